@@ -0,0 +1,88 @@
+#ifndef CENTER_PATTERN_DATABASE_H
+#define CENTER_PATTERN_DATABASE_H
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include "twist_sequence.h"
+#include "cube_centers.h"
+#include "pattern_combination.h"
+
+namespace ai {
+	//Pattern databases for the centers of a cube of a given size. The center pieces are split into orbits, the
+	//sets of 24 positions pieces can be moved between, and a pattern is the positions of the 4 pieces of one
+	//colour in an orbit together with the face they belong on. The database stores the number of twists needed
+	//to move the pieces of every pattern onto their face using a given set of TwistSequences, found with a
+	//retrograde breadth-first search from the solved patterns. The distances are saved to a file that is
+	//memory-mapped when the database is loaded
+	class CenterPatternDatabase {
+		private:
+			static constexpr int face_count = 6;
+
+			//number of positions in an orbit, and number of pieces of each colour in an orbit
+			static constexpr int orbit_size = 24;
+			static constexpr int colour_pieces = 4;
+
+			//number of ways to place the 4 pieces of a colour in an orbit
+			static constexpr int placement_count = 10626;
+
+			//number of patterns in an orbit. A pattern's index is the index of the face its pieces belong on
+			//times 'placement_count', plus the rank of the positions of its pieces
+			static constexpr int pattern_count = face_count*placement_count;
+
+			//identifies files written by this version of the program
+			static constexpr uint32_t magic = 0x42445043;
+			static constexpr uint32_t version = 1;
+
+			//positions of each orbit in the pieces of the CubeCenters, in increasing order
+			typedef std::array<uint16_t, orbit_size> Orbit;
+
+			//how a TwistSequence moves the patterns of an orbit
+			struct PatternMove {
+				//index in the orbit each position is moved to
+				std::array<uint8_t, orbit_size> positions;
+
+				//face the pieces belonging on each face belong on after the move
+				std::array<uint8_t, face_count> faces;
+
+				//number of twists in the TwistSequence
+				int cost;
+			};
+
+			boost::iostreams::mapped_file_source file;
+
+			std::vector<Orbit> orbits;
+
+			//start of the distances of each orbit in the memory-mapped file
+			std::vector<const uint8_t*> distances;
+
+			PatternCombination combination;
+
+			//returns the orbits of the centers of the given size
+			static std::vector<Orbit> find_orbits(const int size);
+
+			//returns the rank of the given positions, which must be in increasing order
+			static int rank_placement(const std::array<uint8_t, colour_pieces>& placement);
+
+			//computes the distance of every pattern of the given orbit with a retrograde breadth-first search
+			static std::vector<uint8_t> generate_distances(const Orbit& orbit, const int pieces_in_center, const std::vector<PatternMove>& moves);
+
+			//generates the database for centers of the given size and writes it to the given path
+			static void generate(const boost::filesystem::path& file_path, const int size, const std::vector<TwistSequence>& twist_sequences,
+					const std::size_t key);
+
+		public:
+			//loads the database for centers of the given size from the given path. If the file doesn't exist, or was
+			//generated for other TwistSequences, the database is generated with the given TwistSequences and saved first
+			CenterPatternDatabase(const boost::filesystem::path& file_path, const int size, const std::vector<TwistSequence>& twist_sequences,
+					const PatternCombination combination = PatternCombination::SUM);
+
+			//returns the distances of the patterns of the given centers, combined as specified when the database was loaded.
+			//Only the patterns of the pieces belonging on the faces with their bit set in 'faces' are included
+			int operator()(const cube::CubeCenters& centers, const int faces = (1 << face_count) - 1) const;
+	};
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef CENTER_PLANNER_H
+#define CENTER_PLANNER_H
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include "twist_sequence.h"
+#include "cube_centers.h"
+#include "search_limits.h"
+
+namespace ai {
+	//Deterministic alternative to the center searches of the CenterSolver. Each center piece is placed with a 3-cycle:
+	//a commutator that cycles 3 pieces of an orbit without moving any other piece, conjugated with setup twists that
+	//move the 3 positions to be cycled into the commutator's positions. The setups of every 3-cycle of each orbit are
+	//found once, with a breadth-first search over the cycles, so solving the centers needs no search
+	class CenterPlanner {
+		private:
+			static constexpr int orbit_size = 24;
+
+			//number of cycles of an orbit. The cycle that moves the piece at index a to index b, the piece at b
+			//to c, and the piece at c to a has the index (a*orbit_size + b)*orbit_size + c
+			static constexpr int cycle_count = orbit_size*orbit_size*orbit_size;
+
+			//the 3-cycles of one orbit
+			struct OrbitLibrary {
+				//positions of the orbit in the pieces of the CubeCenters, in increasing order
+				std::vector<int> positions;
+
+				//commutator that cycles 3 pieces of the orbit, and the index of its cycle
+				TwistSequence commutator;
+				int commutator_cycle;
+
+				//twists that move the pieces of the orbit, and the index each moves the piece at each index to
+				std::vector<cube::Twist> setup_twists;
+				std::vector<std::array<uint8_t, orbit_size>> setup_destinations;
+
+				//index in 'setup_twists' of the first setup twist of each cycle. The commutator's own cycle has
+				//no setup and is set to -1, and cycles that can't be made are set to -2
+				std::vector<int16_t> first_setup_twist;
+			};
+
+			int size;
+
+			std::vector<OrbitLibrary> libraries;
+
+			//finds the setups of every cycle of the given library with a breadth-first search from the commutator's cycle
+			void build_library(OrbitLibrary& library);
+
+			//returns the twists that make the given cycle of the given library
+			TwistSequence make_cycle(const OrbitLibrary& library, const int cycle) const;
+
+		public:
+			//returns the positions of each orbit of centers of the given size, in increasing order, with the commutator of
+			//'commutators' that cycles 3 of its pieces without moving any other piece. 'commutators' are the commutators of
+			//CenterSolver::generate_commutators, which leave out their last twist, a 90 degree rotation of the top face, 
+			//and are returned with it. Orbits no commutator cycles are returned with an empty commutator
+			static std::vector<std::pair<std::vector<int>, TwistSequence>> find_orbit_commutators(const int size, 
+					const std::vector<TwistSequence>& commutators);
+
+			//builds the library of 3-cycles for centers of the given size from the commutators of
+			//CenterSolver::generate_commutators
+			CenterPlanner(const int size, const std::vector<TwistSequence>& commutators);
+
+			//returns the twists that solve the given centers. The limits are checked before each 3-cycle, and if
+			//one is reached the twists planned so far are returned with the reason
+			search::SearchResult solve(const cube::CubeCenters& centers, const search::SearchLimits& limits) const;
+	};
+}
+
+#endif
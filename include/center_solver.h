@@ -7,14 +7,87 @@
 #include "twist.h"
 #include "heuristic_cube_state.h"
 #include "hash.h"
+#include "search_limits.h"
+#include "center_pattern_database.h"
+#include "center_planner.h"
+#include "orbit_centers.h"
 #include <array>
 #include <unordered_set>
 #include <boost/functional/hash.hpp>
 #include <memory>
 #include <cmath>
+#include <chrono>
+#include <string>
+#include <functional>
 #include <boost/optional.hpp>
 
 namespace ai {
+	//configures the strategies used by a CenterSolver. The solver alternates between its two strategies
+	//in phases, and a phase gives way to the other strategy once its progress stalls
+	struct CenterSolverSettings {
+		//whether the first phase uses strategy 1. Otherwise the solver starts with the commutator based search
+		bool begin_with_strategy_1 = true;
+
+		//number of states generated between two measurements of a phase's progress
+		int measurement_window = 1000;
+
+		//number of consecutive measurements without a newly solved piece after which a strategy 1
+		//phase gives way to the commutator based search
+		int strategy_1_patience = 3;
+
+		//number of consecutive measurements without a newly solved piece after which a commutator
+		//based phase gives way to strategy 1
+		int strategy_2_patience = 150;
+
+		//time without a newly solved piece after which a phase gives way to the other strategy, however
+		//many measurements have passed, or 0 to only count measurements. The progress is measured from the
+		//states the search generates, so the growth of its open list doesn't take part in the decision
+		std::chrono::milliseconds stall_time = std::chrono::milliseconds(0);
+
+		//maximum number of phases. The last phase runs the commutator based search until the centers are solved
+		int max_phases = 4;
+
+		//whether the commutator based search stores only the children it needs, see best_first_search
+		bool partial_expansion = true;
+
+		//time spent searching for shorter solutions once the commutator based search has found its first
+		//solution. The budget is spent by each commutator based phase, so refinement is off unless enabled
+		std::chrono::milliseconds refinement_budget = std::chrono::milliseconds(0);
+
+		//whether the searches are guided by center pattern databases for each strategy. Otherwise they
+		//count the unsolved pieces. The databases are generated on the first solve of each cube size if
+		//they aren't in 'pattern_database_dir', which takes a while on larger cubes, so they are off unless
+		//enabled
+		bool use_pattern_databases = false;
+
+		//how the distances of the pattern databases are combined
+		PatternCombination pattern_combination = PatternCombination::SUM;
+
+		//directory the pattern databases are stored to, relative to the working directory. Each size has the
+		//files centers_<size>_strategy_1.pdb and centers_<size>_strategy_2.pdb
+		boost::filesystem::path pattern_database_dir = "tables";
+
+		//whether the centers are solved by a CenterPlanner, which places every piece with a 3-cycle
+		//instead of searching. Its solutions are longer, but its run time grows linearly with the cube
+		bool constructive = false;
+
+		//whether the centers are solved face by face: the face with the most pieces solved first, then 
+		//the face opposite it, then the other 4 faces together. Each stage only searches moves that keep
+		//the faces solved by the earlier stages solved
+		bool staged = false;
+
+		//whether each orbit of the centers is solved by its own search, with the orbits searched concurrently.
+		//The searches only use 3-cycles that move no piece of another orbit, so their solutions can be joined
+		bool orbit_parallel = false;
+
+		//maximum number of slice twists conjugating the commutator of an orbit in the moves of its search
+		int orbit_setup_depth = 2;
+
+		//number of threads the orbits are searched on, or 0 to use every core. Solvers that run alongside
+		//others, like the entries of a portfolio, should be given their share of the cores
+		int orbit_threads = 0;
+	};
+
 	class CenterSolver : public TwistProvider {
 		private:
 			//callable that returns a value determined by applying a heuristic 
@@ -23,6 +96,60 @@ namespace ai {
 				int operator()(const cube::CubeCenters& centers);
 			};
 
+			//callable that returns the estimate of the pattern database of the phase running on the calling thread
+			struct PatternDatabaseHeuristic {
+				int operator()(const cube::CubeCenters& centers);
+			};
+
+			//the pattern database used by PatternDatabaseHeuristic. Heuristics are constructed by the searches,
+			//so the database is set for the thread running the search while a phase runs
+			static thread_local const CenterPatternDatabase* active_pattern_database;
+
+			//pattern databases for strategy 1 and the commutator based search, loaded on the first solve
+			std::unique_ptr<CenterPatternDatabase> strategy_1_database;
+			std::unique_ptr<CenterPatternDatabase> strategy_2_database;
+
+			//Heuristic used by the staged searches. The heuristic returns the estimate of the active pattern 
+			//database for the pieces belonging on the faces of the stage running on the calling thread, or without
+			//one, the number of pieces on those faces that don't belong there
+			struct StageHeuristic {
+				int operator()(const cube::CubeCenters& centers);
+			};
+
+			//bit n is set for face n if it is solved by the stage running on the calling thread or an earlier stage
+			static thread_local int active_stage_faces;
+
+			//returns the number of pieces on the faces with their bit set in 'faces' that don't belong there
+			static int count_unsolved_pieces(const cube::CubeCenters& centers, const int faces);
+
+			//returns the TwistSequences of a stage: every slice twist, face twist and commutator, conjugated with
+			//every whole cube rotation, that keeps the pieces of the faces with their bit set in 'solved_faces' on 
+			//their faces
+			std::vector<TwistSequence> generate_stage_moves(const cube::CubeCenters& centers, const int solved_faces);
+
+			//solves the centers in the stages described by CenterSolverSettings::staged
+			search::SearchStatus solve_staged(const cube::CubeCenters& root_state);
+
+			//Heuristic used by the orbit searches. Every piece on the face opposite the one it belongs to adds 2, 
+			//and every other unsolved piece adds 1
+			struct OrbitHeuristic {
+				int operator()(const cube::OrbitCenters& orbit);
+			};
+
+			//splits the given centers into an OrbitCenters for each orbit with the given positions
+			static std::vector<cube::OrbitCenters> split_orbits(const cube::CubeCenters& centers, const std::vector<std::vector<int>>& orbit_positions);
+
+			//solves the orbits of the centers concurrently, as described by CenterSolverSettings::orbit_parallel
+			search::SearchStatus solve_orbits(const cube::CubeCenters& root_state);
+
+			//loads the pattern databases for the given centers if they are used and aren't loaded yet
+			void load_pattern_databases(const cube::CubeCenters& centers);
+
+			//runs the search of the given strategy, guided by the given Heuristic
+			template<typename Heuristic>
+			search::SearchResult run_search(const cube::CubeCenters& state, const bool use_strategy_1, 
+					const std::function<bool(const cube::CubeCenters&)>& is_finished, const search::SearchLimits& phase_limits);
+
 			//generates a set of commutators that, when combined with rotations of the whole 
 			//cube and rotations of each face, can be used to swap any two centers in the given
 			//CubeCenters object
@@ -41,10 +168,51 @@ namespace ai {
 
 			//counts the number of center pieces solved in the given CubeCenters object
 			int count_solved_pieces(const cube::CubeCenters& centers);
+
+			//measures the progress of a phase as the number of center pieces solved in the best state 
+			//generated so far, and decides when the phase has stalled
+			class ProgressMonitor {
+				private:
+					int measurement_window;
+					int patience;
+					int initial_solved_pieces;
+					int best_solved_pieces;
+					int window_start_solved_pieces;
+					int generated_states = 0;
+					int stalled_windows = 0;
+					std::chrono::milliseconds stall_time;
+					std::chrono::steady_clock::time_point start_time;
+					std::chrono::steady_clock::time_point last_gain_time;
+					bool stalled = false;
+				public:
+					ProgressMonitor(const int measurement_window, const int patience, const std::chrono::milliseconds stall_time, 
+							const int solved_pieces);
+
+					//records a generated state with the given number of solved pieces. Returns true once 
+					//'patience' consecutive measurement windows have passed without a newly solved piece, or
+					//a measurement finds no newly solved piece for 'stall_time'
+					bool record(const int solved_pieces);
+
+					//logs the progress made during the phase
+					void log_progress(const int phase, const std::string& strategy_name) const;
+			};
+
+			//runs one phase of the center search on the given state with the given strategy. If 'monitored' 
+			//is true, the phase is stopped once the progress monitor decides it has stalled, and the state
+			//closest to the goal is returned with a CANCELLED status
+			search::SearchResult run_phase(const cube::CubeCenters& state, const int phase, const bool use_strategy_1, const bool monitored);
+
+			//bounds the resources used by each search
+			search::SearchLimits limits;
+
+			CenterSolverSettings settings;
 		public:
+			CenterSolver(const search::SearchLimits& limits = search::SearchLimits(), const CenterSolverSettings& settings = CenterSolverSettings()) : 
+				limits(limits), settings(settings) {}
 			
-			//solves the given cube object
-			void solve(const cube::CubeCenters& root_state);
+			//solves the given cube object. Returns the reason the centers couldn't be solved
+			//if one of the search limits was reached, and SOLVED otherwise
+			search::SearchStatus solve(const cube::CubeCenters& root_state);
 	
 	};
 }
@@ -0,0 +1,96 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+#include <functional>
+#include <mutex>
+#include <memory>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/sync/file_lock.hpp>
+#include "twist.h"
+#include "twist_sequence.h"
+
+namespace ai {
+	namespace search {
+		//specifies where and how often long-running searches save their progress so a
+		//restarted process can resume them
+		struct CheckpointSettings {
+			//directory the checkpoint files are written to
+			boost::filesystem::path directory;
+
+			//time between two checkpoints of a search
+			std::chrono::seconds interval = std::chrono::seconds(60);
+
+			CheckpointSettings(const boost::filesystem::path& directory) : directory(directory) {}
+
+			//returns the path of the checkpoint file with the given kind and key. The key identifies
+			//the search or solve the file belongs to, so concurrent solves don't share files
+			boost::filesystem::path file_path(const std::string& kind, const std::size_t key) const {
+				return directory/(kind + "_" + std::to_string(key) + ".bin");
+			}
+		};
+
+		//helpers for reading and writing the binary checkpoint files
+		namespace checkpoint {
+			//identifies checkpoint files written by this version of the program
+			const uint32_t magic = 0x4d52434b;
+			const uint32_t version = 1;
+
+			template<typename T>
+			void write_value(std::ostream& stream, const T& value) {
+				stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+			}
+
+			//reads a value written by write_value. Throws std::runtime_error if the stream ends early
+			template<typename T>
+			T read_value(std::istream& stream) {
+				T value;
+				if (!stream.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+					throw std::runtime_error("Checkpoint ended unexpectedly");
+				}
+				return value;
+			}
+
+			void write_twists(std::ostream& stream, const std::vector<cube::Twist>& twists);
+			std::vector<cube::Twist> read_twists(std::istream& stream);
+
+			//writes the magic number, the version and the given key that identifies the search or solve
+			void write_header(std::ostream& stream, const std::size_t key);
+
+			//returns true if the stream starts with a header written by write_header with the given key
+			bool read_header(std::istream& stream, const std::size_t key);
+
+			//returns a hash identifying the given set of TwistSequences
+			std::size_t hash_twist_sequences(const std::vector<TwistSequence>& twist_sequences);
+
+			//writes a checkpoint file using 'writer'. The data is written to a temporary file that then 
+			//replaces the checkpoint, so a process killed while writing leaves the old checkpoint intact
+			void save(const boost::filesystem::path& file_path, const std::function<void(std::ostream&)>& writer);
+
+			//deletes the given checkpoint file if it exists
+			void remove(const boost::filesystem::path& file_path);
+
+			//holds a lock on a file for as long as it exists, so a file that is generated when it's missing is
+			//only generated once. The lock is taken on '<file>.lock', and excludes both other processes and
+			//other threads of this one, since the file lock alone doesn't exclude threads
+			class FileLock {
+				private:
+					std::unique_lock<std::mutex> thread_lock;
+					std::unique_ptr<boost::interprocess::file_lock> process_lock;
+
+				public:
+					FileLock(const boost::filesystem::path& file_path);
+					~FileLock();
+
+					FileLock(const FileLock&) = delete;
+					FileLock& operator=(const FileLock&) = delete;
+			};
+		}
+	}
+}
+
+#endif
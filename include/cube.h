@@ -5,6 +5,7 @@
 #include "face.h"
 #include <unordered_map>
 #include <memory>
+#include <iostream>
 
 namespace cube {
 	class Twist;
@@ -28,6 +29,16 @@ namespace cube {
 			//	2 - counter-clockwise twist
 			std::unique_ptr<uint8_t[]> corners;
 
+			//bit n is set if every piece of edge n has the same position and orientation. The bits are
+			//updated as edges are moved, so the paired edges are known without looking at every piece
+			uint16_t paired_edges;
+
+			//sets the bit of the given edge in 'paired_edges' from the pieces of the edge
+			void update_paired_edge(const int edge);
+
+			//sets every bit of 'paired_edges' from the pieces of the edges
+			void update_paired_edges();
+
 			//helper functions for manipulating the pieces
 			
 			//flips the orientation of an edge if the given face is Top or Bottom. Used for
@@ -75,9 +86,24 @@ namespace cube {
 			int get_edge_count() const {return edge_count;}
 			int get_corner_count() const {return corner_count;}
 
+			//returns a bitmask of the edges whose pieces all have the same position and orientation
+			uint16_t get_paired_edges() const {return paired_edges;}
+
+			//returns true if every piece of the given edge has the same position and orientation
+			bool edge_is_paired(const int edge) const {return paired_edges >> edge & 1;}
+
+			//returns the number of bytes used by the cube, including the pieces it owns
+			std::size_t get_memory_usage() const {return sizeof(Cube) + edge_width*edge_count + corner_count;}
+
 			//performs a rotation on the cube
 			void rotate(const Twist& twist);
 
+			//writes the pieces of the cube to the given binary stream
+			void write(std::ostream& stream) const;
+
+			//replaces the pieces of the cube with pieces written by a cube of the same size
+			void read(std::istream& stream);
+
 			bool operator==(const Cube& cube) const;
 			Cube(Cube&& cube) = default;
 	};
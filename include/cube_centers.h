@@ -6,6 +6,7 @@
 #include <unordered_map>
 #include <memory>
 #include <array>
+#include <iostream>
 #include <boost/optional.hpp>
 
 namespace cube {
@@ -44,6 +45,24 @@ namespace cube {
 			//
 			//all 8 bits specify position
 			std::unique_ptr<uint8_t[]> centers;
+
+			//value of the pieces of each face when solved, and of the pieces of the face opposite it. Both are indexed by face
+			std::array<uint8_t, 6> solved_values;
+			std::array<uint8_t, 6> opposed_values;
+
+			//number of pieces on the face they belong to when solved, and on the face opposite the one they belong to.
+			//The counts are updated as pieces are moved, so they are known without looking at every piece
+			int solved_pieces;
+			int opposed_pieces;
+
+			//recomputes the solved values of each face and the piece counts from every piece
+			void count_pieces();
+
+			//adds 'sign' times the contribution of the piece at the given index, which is on the given face, to the piece counts
+			void count_piece(const int piece_index, const Face face, const int sign) {
+				solved_pieces += sign*(centers[piece_index] == solved_values[static_cast<int>(face)]);
+				opposed_pieces += sign*(centers[piece_index] == opposed_values[static_cast<int>(face)]);
+			}
 			
 			//helper functions for manipulating the pieces
 			//
@@ -57,8 +76,9 @@ namespace cube {
 			//performs a 90 degree rotation on the outermost layer of the given face
 			void rotate_face(const Face face, const int degrees);
 
-			//performs a 90 degree rotation on the specified slice of the cube
-			void rotate_slice(const Face slice_face, const int layer, const int degrees);
+			//performs a 90 degree rotation on the specified slice of the cube. If 'update_counts' is true, 
+			//the piece counts are updated for the pieces moved
+			void rotate_slice(const Face slice_face, const int layer, const int degrees, const bool update_counts);
 
 		public:
 			//constructs a solved cube of the given size
@@ -76,9 +96,24 @@ namespace cube {
 			int get_solved_center_value(const Face face) const;
 			int get_pieces_in_center() const {return center_size;}
 
+			//returns the number of pieces on the face they belong to when solved
+			int get_solved_piece_count() const {return solved_pieces;}
+
+			//returns the number of pieces on the face opposite the face they belong to when solved
+			int get_opposed_piece_count() const {return opposed_pieces;}
+
+			//returns the number of bytes used by the centers, including the pieces they own
+			std::size_t get_memory_usage() const;
+
 			//performs a rotation on the cube
 			void rotate(const Twist& twist);
 
+			//writes the pieces of the centers to the given binary stream
+			void write(std::ostream& stream) const;
+
+			//replaces the pieces of the centers with pieces written by centers of the same size
+			void read(std::istream& stream);
+
 			bool operator==(const CubeCenters& cube) const;
 			CubeCenters(CubeCenters&& cube) = default;
 	};
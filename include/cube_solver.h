@@ -4,18 +4,81 @@
 #include "twist_listener.h"
 #include "twist_provider.h"
 #include "combined_cube.h"
+#include "search_limits.h"
+#include "center_solver.h"
+#include "edge_solver.h"
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
 #include <boost/optional.hpp>
+#include <boost/filesystem.hpp>
 
 namespace ai {
+	//one configuration of the center and edge solvers raced by a CubeSolver in portfolio mode
+	struct PortfolioEntry {
+		CenterSolverSettings center_settings;
+		EdgeSolverSettings edge_settings;
+	};
+
 	class CubeSolver : public TwistListener, public TwistProvider {
 		private:
 			boost::optional<cube::CombinedCube> comb_cube;
+
+			//bounds the resources used by each search made while solving
+			search::SearchLimits limits;
+
+			//configurations of the center and edge solvers. If there is more than one, the
+			//configurations race each other on every stage and the best solution is kept
+			std::vector<PortfolioEntry> portfolio;
+
+			//time the other solvers of the portfolio are given to find a shorter solution
+			//once the first solution of a stage has been found
+			std::chrono::milliseconds selection_window;
+
+			//solves a stage of the cube with the solvers configured by the given entry, bounded by the given limits
+			typedef std::function<search::SearchResult(const PortfolioEntry&, const search::SearchLimits&)> StageSolver;
+
+			//runs 'solve_stage' with every entry of the portfolio on its own thread, and cancels the searches
+			//still running once the selection window after the first solution closes. Returns the shortest 
+			//solution found, or the result of the first entry if no entry solved the stage
+			search::SearchResult race(const StageSolver& solve_stage);
+
+			//twists made since the current solve started
+			std::vector<cube::Twist> solve_twists;
+
+			//saves the twists made while solving 'initial_cube' and the number of stages completed
+			void save_checkpoint(const boost::filesystem::path& file_path, const cube::CombinedCube& initial_cube, const int completed_stages);
+
+			//replays the twists saved by an earlier solve of 'initial_cube' and returns the number of
+			//stages it completed, or 0 if there is no usable checkpoint
+			int load_checkpoint(const boost::filesystem::path& file_path, const cube::CombinedCube& initial_cube);
 		public:
+			CubeSolver(
+				const search::SearchLimits& limits = search::SearchLimits(), 
+				const std::vector<PortfolioEntry>& portfolio = {PortfolioEntry()},
+				const std::chrono::milliseconds selection_window = std::chrono::milliseconds(0)) : 
+				limits(limits), portfolio(portfolio), selection_window(selection_window) {
+					if (portfolio.empty()) {
+						throw std::invalid_argument("The portfolio needs at least one entry");
+					}
+				}
+
 			void twist(const cube::Twist& twist) override {
 				comb_cube.get().rotate(twist);
+				solve_twists.push_back(twist);
 				notify_listeners({twist});
 			}
-			void solve(const cube::CombinedCube& comb_cube);
+
+			void solution_improved(const std::vector<cube::Twist>& twists) override {
+				notify_improvement(twists);
+			}
+
+			//solves the given cube. Returns the reason the cube couldn't be solved if one of 
+			//the search limits was reached, and SOLVED otherwise. If the limits have checkpoint
+			//settings, a checkpoint is saved after each stage and a solve of the same cube
+			//continues after the last stage completed by an earlier process
+			search::SearchStatus solve(const cube::CombinedCube& comb_cube);
 
 	};
 }
@@ -16,15 +16,17 @@ namespace ai {
 		StateType cube;
 		//sequence of twists made to get from the parent to this state
 		boost::optional<TwistSequence> twist_seq;
+		//index of twist_seq in the set of TwistSequences used to build the state-space, or -1 for the root state
+		int twist_seq_index;
 
-		CubeState(const std::shared_ptr<CubeState> parent, const StateType& cube, const TwistSequence& twist_seq) : 
-			parent(parent), cube(cube), twist_seq(twist_seq) {}
+		CubeState(const std::shared_ptr<CubeState> parent, const StateType& cube, const TwistSequence& twist_seq, const int twist_seq_index) : 
+			parent(parent), cube(cube), twist_seq(twist_seq), twist_seq_index(twist_seq_index) {}
 		
-		CubeState(const std::shared_ptr<CubeState> parent, const StateType&& cube, const TwistSequence& twist_seq) : 
-			parent(parent), cube(cube), twist_seq(twist_seq) {}
+		CubeState(const std::shared_ptr<CubeState> parent, const StateType&& cube, const TwistSequence& twist_seq, const int twist_seq_index) : 
+			parent(parent), cube(cube), twist_seq(twist_seq), twist_seq_index(twist_seq_index) {}
 
 		CubeState(const StateType& cube) : 
-			cube(cube) {}
+			cube(cube), twist_seq_index(-1) {}
 	};
 }
 
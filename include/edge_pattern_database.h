@@ -0,0 +1,93 @@
+#ifndef EDGE_PATTERN_DATABASE_H
+#define EDGE_PATTERN_DATABASE_H
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include "twist_sequence.h"
+#include "cube.h"
+#include "pattern_combination.h"
+
+namespace ai {
+	//Pattern databases for pairing the edges of a cube of a given size. The wings are split into groups: the wings
+	//that can be moved between the positions n and edge_width-1-n of every edge, together with the middle wings
+	//on odd cubes. A pattern is the positions and orientations of the wings of one piece in a group, and the
+	//database stores the number of twists needed to move them into the same edge with the same orientation using
+	//a given set of TwistSequences, found with a retrograde breadth-first search from the paired patterns. Which
+	//piece the wings belong to doesn't matter, so the table of a group is shared by every piece. The distances
+	//are saved to a file that is memory-mapped when the database is loaded
+	class EdgePatternDatabase {
+		private:
+			static constexpr int edge_count = 12;
+
+			//number of positions of the wings that are paired with each other in a group, and of the middle wings
+			static constexpr int paired_positions = 24;
+			static constexpr int middle_positions = 12;
+
+			//number of states of a wing, a position and an orientation, in a group
+			static constexpr int wing_states = 2*paired_positions;
+			static constexpr int middle_states = 2*middle_positions;
+
+			//identifies files written by this version of the program
+			static constexpr uint32_t magic = 0x42445045;
+			static constexpr uint32_t version = 1;
+
+			//positions of each group in the wings of the Cube. The first 24 are the wings paired with each
+			//other, two from every edge, followed by the middle wing of every edge on odd cubes
+			typedef std::vector<int> Group;
+
+			//how a TwistSequence moves the wings of a group
+			struct PatternMove {
+				//index in the group each position is moved to, and whether the wing is flipped on the way
+				std::vector<uint8_t> positions;
+				std::vector<uint8_t> flips;
+
+				//number of twists in the TwistSequence
+				int cost;
+			};
+
+			boost::iostreams::mapped_file_source file;
+
+			int edge_width;
+
+			//number of middle wing states of each pattern, 1 for even cubes. A pattern's index is the state of
+			//its lower paired wing times 'wing_states', plus the state of its higher paired wing, all times
+			//'middle_count', plus the state of its middle wing
+			int middle_count;
+
+			//number of patterns of each group
+			int pattern_count;
+
+			std::vector<Group> groups;
+
+			//start of the distances of each group in the memory-mapped file
+			std::vector<const uint8_t*> distances;
+
+			PatternCombination combination;
+
+			//returns the groups of the wings of a cube of the given size
+			static std::vector<Group> find_groups(const int size);
+
+			//computes the distance of every pattern of a group with a retrograde breadth-first search
+			static std::vector<uint8_t> generate_distances(const int middle_count, const std::vector<PatternMove>& moves);
+
+			//generates the database for cubes of the given size and writes it to the given path
+			static void generate(const boost::filesystem::path& file_path, const int size, const std::vector<TwistSequence>& twist_sequences,
+					const std::size_t key);
+
+		public:
+			//loads the database for cubes of the given size from the given path. If the file doesn't exist, or was
+			//generated for other TwistSequences, the database is generated with the given TwistSequences and saved first
+			EdgePatternDatabase(const boost::filesystem::path& file_path, const int size, const std::vector<TwistSequence>& twist_sequences,
+					const PatternCombination combination = PatternCombination::SUM);
+
+			//returns the distances of the patterns of the given cube. The distances of each piece's patterns are
+			//combined as specified when the database was loaded, and the pieces are combined the same way, leaving
+			//out the 'ignored_pieces' pieces furthest from being paired
+			int operator()(const cube::Cube& cube, const int ignored_pieces = 0) const;
+	};
+}
+
+#endif
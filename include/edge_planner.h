@@ -0,0 +1,57 @@
+#ifndef EDGE_PLANNER_H
+#define EDGE_PLANNER_H
+
+#include <vector>
+#include <cstdint>
+#include "twist_sequence.h"
+#include "cube.h"
+#include "search_limits.h"
+
+namespace ai {
+	//Deterministic alternative to the search for the first 10 edges of the EdgeSolver, using the free-slice method. An
+	//inner slice is turned, the edge it brings a wing into is replaced with a face trigger, and the slice and the
+	//trigger are undone. This leaves the centers solved and moves only a few wings, so each wing is brought into
+	//the edge being paired with one of these moves, conjugated with setup twists of the faces. The moves are
+	//found once, so pairing an edge is a scan of the moves that bring a matching wing into each of its positions
+	class EdgePlanner {
+		private:
+			//a slice move conjugated with setup twists, and the wings it moves
+			struct WingMove {
+				TwistSequence twists;
+
+				//position each moved wing is moved from and to, and whether it is flipped on the way
+				struct MovedWing {
+					uint8_t source;
+					uint8_t destination;
+					bool flipped;
+				};
+				std::vector<MovedWing> moved_wings;
+			};
+
+			int size;
+
+			std::vector<WingMove> moves;
+
+			//indices in 'moves' of the moves that move a wing into each position, shortest first
+			std::vector<std::vector<int>> moves_into;
+
+			//returns the face twist sequences of up to 'depth' twists that move the wings differently, shortest first
+			std::vector<TwistSequence> generate_setups(const int depth) const;
+
+			//returns the slice moves before their setups: every inner slice turned around a face trigger whose
+			//turning face is parallel to the slice, so the trigger and the slice leave each other's centers alone
+			std::vector<TwistSequence> generate_slice_moves() const;
+
+		public:
+			//finds the moves for cubes of the given size, with setups of up to 'setup_depth' face twists
+			EdgePlanner(const int size, const int setup_depth = 2);
+
+			//returns the twists that pair all but 2 of the edges of the given cube. On odd cubes each edge is paired
+			//to its middle wing, which is never moved, and on even cubes to the piece and orientation most of its
+			//wings share. The limits are checked before each move, and if one is reached the twists planned so far
+			//are returned with the reason
+			search::SearchResult solve(const cube::Cube& cube, const search::SearchLimits& limits) const;
+	};
+}
+
+#endif
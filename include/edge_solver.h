@@ -4,27 +4,66 @@
 #include <vector>
 #include <unordered_map>
 #include <array>
+#include <chrono>
 #include "twist_listener.h"
 #include "twist_sequence.h"
 #include "twist.h"
 #include "heuristic_cube_state.h"
 #include "cube.h"
 #include "twist_provider.h"
+#include "search_limits.h"
+#include "edge_pattern_database.h"
+#include "orbit_edges.h"
+#include "edge_planner.h"
+#include <memory>
 
 namespace ai {
+	//configures the searches used by an EdgeSolver
+	struct EdgeSolverSettings {
+		//whether the edge searches store only the children they need, see best_first_search
+		bool partial_expansion = false;
+
+		//time spent searching for shorter solutions once each edge search has found its first solution.
+		//The budget is spent by each of the edge searches of a solve, so refinement is off unless enabled
+		std::chrono::milliseconds refinement_budget = std::chrono::milliseconds(0);
+
+		//whether the search for the first 10 edges is guided by an edge pattern database on 4x4 and 5x5
+		//cubes. Otherwise it uses EdgeHeuristic. The database is generated on the first solve of each size
+		//if it isn't in 'pattern_database_dir', so it is off unless enabled
+		bool use_pattern_databases = false;
+
+		//how the distances of the pattern database are combined
+		PatternCombination pattern_combination = PatternCombination::SUM;
+
+		//directory the pattern database is stored to, relative to the working directory, as edges_<size>.pdb
+		boost::filesystem::path pattern_database_dir = "tables";
+
+		//whether the first 10 edges are paired by an EdgePlanner, which brings each wing into its edge with a
+		//free-slice move instead of searching. Its solutions are longer, but its run time grows linearly with
+		//the number of wings
+		bool constructive = false;
+
+		//whether each orbit of the wings is paired by its own search, with the orbits searched concurrently. The
+		//orbits are paired against a shared frame: the middle wings on odd cubes, and otherwise the piece most of
+		//each edge's wings belong to. The searches only use wing swaps that move no other piece, so their
+		//solutions can be joined, and the last 2 edges don't need a search of their own
+		bool orbit_parallel = false;
+
+		//maximum number of twists conjugating the wing swaps of an orbit in the moves of its search
+		int orbit_setup_depth = 2;
+
+		//number of threads the orbits are paired on, or 0 to use every core
+		int orbit_threads = 0;
+	};
+
 	class EdgeSolver : public TwistProvider {
 		private:
 			//Heuristic used for the best-first search to solve the first 10 edges.
 			//The heuristic returns the number of edge pieces left to solve
+			//
+			//Each edge is greedily assigned the piece with the most pieces placed in it with a common
+			//orientation. The heuristic is computed in fixed size arrays, without allocating
 			struct EdgeHeuristic {
-				struct EdgeAssignment {
-					int edge;
-					int piece;
-					int placed_pieces;
-					EdgeAssignment(const int edge, const int piece, const int placed_pieces) :
-						edge(edge), piece(piece), placed_pieces(placed_pieces) {}
-				
-				};
 				int operator()(const cube::Cube& cube);	
 			};
 
@@ -35,8 +74,30 @@ namespace ai {
 				int operator()(const cube::Cube& cube);
 			};
 
+			//Heuristic used for the best-first search to solve the first 10 edges when pattern databases are used.
+			//The heuristic returns the estimate of the pattern database of the search running on the calling
+			//thread, leaving out the 2 pieces furthest from being paired
+			struct PatternDatabaseHeuristic {
+				int operator()(const cube::Cube& cube);
+			};
+
+			//the pattern database used by PatternDatabaseHeuristic. Heuristics are constructed by the searches,
+			//so the database is set for the thread running the search while it runs
+			static thread_local const EdgePatternDatabase* active_pattern_database;
+
+			//pattern database for the search for the first 10 edges, loaded on the first solve
+			std::unique_ptr<EdgePatternDatabase> first_ten_edges_database;
+
+			//Heuristic used by the orbit searches. The heuristic returns the number of wings that don't match the frame
+			struct OrbitHeuristic {
+				int operator()(const cube::OrbitEdges& orbit);
+			};
+
 			std::array<int, 2> degrees = {-90, 90};
 
+			//logs a solution found by one of the edge searches and reports it to the listeners
+			void log_improvement(const std::vector<cube::Twist>& twists);
+
 			//generates the commutators nessesary to swap any two edges on the front-top
 			//and front-back edges of the cube
 			std::vector<TwistSequence> generate_edge_commutators(const cube::Cube& cube);
@@ -47,19 +108,43 @@ namespace ai {
 			//odd cubes
 			TwistSequence generate_edge_flipper(const cube::Cube& cube);
 
-			//returns true if the specified edge is solved on the given cube
-			bool edge_is_solved(const cube::Cube& cube, const int edge);
+			//returns the positions of the wings of each orbit of a cube of the given size: the positions n and
+			//edge_width-1-n of every edge, for every n below edge_width/2
+			static std::vector<std::vector<int>> find_wing_orbits(const int size);
+
+			//returns the piece and orientation, encoded like the edges of a Cube, that the wings of each edge are paired
+			//to. Odd cubes use their middle wings, which the orbit searches don't move. Even cubes greedily give each
+			//edge the piece and orientation shared by most of its wings, giving every piece to one edge
+			static std::vector<uint8_t> choose_frame(const cube::Cube& cube);
+
+			//splits the wings of the given cube into an OrbitEdges for each orbit with the given positions, paired to
+			//the given frame
+			static std::vector<cube::OrbitEdges> split_orbits(const cube::Cube& cube, const std::vector<std::vector<int>>& orbit_positions,
+					const std::vector<uint8_t>& frame);
+
+			//returns true if the given twists move any center piece of a solved cube of the given size off its face
+			static bool moves_centers(const int size, const TwistSequence& twist_seq);
+
+			//pairs the orbits of the wings concurrently, as described by EdgeSolverSettings::orbit_parallel
+			search::SearchStatus solve_orbits(const cube::Cube& cube);
+
+			//bounds the resources used by each search
+			search::SearchLimits limits;
+
+			EdgeSolverSettings settings;
 
 			//solves 10 edges on the cube, leaving 2 unsolved
-			std::vector<cube::Twist> solve_first_ten_edges(const cube::Cube& cube);
+			search::SearchResult solve_first_ten_edges(const cube::Cube& cube);
 
 			//solves the last 2 edges on the cube, finishing the solution of the edges
-			std::vector<cube::Twist> solve_last_two_edges(const cube::Cube& cube);
-			
-			friend struct LastTwoEdgesHeuristic;
+			search::SearchResult solve_last_two_edges(const cube::Cube& cube);
 		public:
-			//solves the edges on the cube
-			void solve(const cube::Cube& cube);
+			EdgeSolver(const search::SearchLimits& limits = search::SearchLimits(), const EdgeSolverSettings& settings = EdgeSolverSettings()) : 
+				limits(limits), settings(settings) {}
+
+			//solves the edges on the cube. Returns the reason the edges couldn't be solved
+			//if one of the search limits was reached, and SOLVED otherwise
+			search::SearchStatus solve(const cube::Cube& cube);
 	};
 }
 
@@ -0,0 +1,106 @@
+#ifndef EXPANSION_BATCH_H
+#define EXPANSION_BATCH_H
+
+#include <vector>
+#include <cstddef>
+#include <functional>
+#include "twist_sequence.h"
+#include "move_pruning.h"
+#include "seen_set.h"
+
+namespace ai {
+	//Structure-of-arrays buffer that holds the children of a state while they are expanded. The
+	//children are generated, hashed, probed against the seen states and scored in separate passes
+	//over the buffer rather than one child at a time. The cubes in the buffer are reused between 
+	//expansions, so children that are rejected as seen never allocate memory
+	template<typename CubeType>
+	struct ExpansionBatch {
+		//the generated children. Only the first 'size' entries belong to the current expansion
+		std::vector<CubeType> children;
+
+		//hash of each child
+		std::vector<std::size_t> hashes;
+
+		//index of the TwistSequence that generated each child
+		std::vector<int> twist_seq_indices;
+
+		//heuristic value of each child. Only set for children that weren't seen before
+		std::vector<int> scores;
+
+		//indices into the buffer of the children that weren't seen before, in the order they were generated
+		std::vector<int> unseen;
+
+		int size = 0;
+
+		//fills the buffer with the children of 'parent' that aren't pruned by 'pruning' and computes
+		//their hashes. 'parent_seq_index' is the index of the TwistSequence that generated 'parent'
+		void expand(
+			const CubeType& parent, 
+			const int parent_seq_index,
+			const std::vector<TwistSequence>& twist_sequences, 
+			const MovePruningTable& pruning) {
+
+				size = 0;
+				for (int seq_index = 0; seq_index < twist_sequences.size(); seq_index++) {
+					if (pruning.is_redundant(parent_seq_index, seq_index)) {
+						continue;
+					}
+					if (size == children.size()) {
+						children.push_back(parent);
+						hashes.push_back(0);
+						twist_seq_indices.push_back(0);
+						scores.push_back(0);
+					}
+					else {
+						children[size] = parent;
+					}
+					for (const auto& twist : twist_sequences[seq_index]) {
+						children[size].rotate(twist);
+					}
+					twist_seq_indices[size] = seq_index;
+					size++;
+				}
+				std::hash<CubeType> hasher;
+				for (int i = 0; i < size; i++) {
+					hashes[i] = hasher(children[i]);
+				}
+		}
+
+		//adds the children that haven't been seen to 'seen' and records them in 'unseen'
+		void filter_seen(SeenSet<CubeType>& seen) {
+			for (int i = 0; i < size; i++) {
+				seen.prefetch(hashes[i]);
+			}
+			unseen.clear();
+			for (int i = 0; i < size; i++) {
+				if (seen.insert(children[i], hashes[i])) {
+					unseen.push_back(i);
+				}
+			}
+		}
+
+		//records the children that aren't in 'seen' in 'unseen', without adding them to 'seen'
+		void find_unseen(const SeenSet<CubeType>& seen) {
+			for (int i = 0; i < size; i++) {
+				seen.prefetch(hashes[i]);
+			}
+			unseen.clear();
+			for (int i = 0; i < size; i++) {
+				if (!seen.contains(children[i], hashes[i])) {
+					unseen.push_back(i);
+				}
+			}
+		}
+
+		//computes the heuristic value of every unseen child
+		template<typename Heuristic>
+		void score_unseen() {
+			Heuristic heuristic;
+			for (const int i : unseen) {
+				scores[i] = heuristic(children[i]);
+			}
+		}
+	};
+}
+
+#endif
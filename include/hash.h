@@ -5,6 +5,8 @@
 #include <algorithm>
 #include <array>
 #include "cube_centers.h"
+#include "orbit_centers.h"
+#include "orbit_edges.h"
 #include "cube.h"
 #include "twist.h"
 
@@ -41,6 +43,30 @@ namespace std {
 		}	
 	};
 	
+	template<>
+	struct hash<cube::OrbitCenters> {
+		size_t operator()(const cube::OrbitCenters& orbit) const {
+			size_t seed = 0;
+			for (int i = 0; i < cube::OrbitCenters::orbit_size; i++) {
+				boost::hash_combine(seed, orbit.get_piece(i));
+			}
+
+			return seed;
+		}
+	};
+
+	template<>
+	struct hash<cube::OrbitEdges> {
+		size_t operator()(const cube::OrbitEdges& orbit) const {
+			size_t seed = 0;
+			for (int i = 0; i < cube::OrbitEdges::orbit_size; i++) {
+				boost::hash_combine(seed, orbit.get_wing(i));
+			}
+
+			return seed;
+		}
+	};
+
 	template <>
 	struct hash<cube::Cube> {
 		size_t operator()(const cube::Cube& cube) const {
@@ -12,9 +12,14 @@ namespace ai {
 		StateType cube;
 		boost::optional<TwistSequence> twist_seq;
 		int score;
-		HeuristicCubeState(const std::shared_ptr<HeuristicCubeState> parent, const StateType& cube, const TwistSequence& twist_seq) : parent(parent), cube(cube), twist_seq(twist_seq), score(Heuristic()(cube)){}
-		HeuristicCubeState(const std::shared_ptr<HeuristicCubeState> parent, const StateType&& cube, const TwistSequence& twist_seq) : parent(parent), cube(cube), twist_seq(twist_seq), score(Heuristic()(cube)) {}
-		HeuristicCubeState(const StateType& cube) : cube(cube), score(Heuristic()(cube)) {}
+		//number of twists made to get from the root state to this state
+		int cost;
+		//index of twist_seq in the set of TwistSequences used to build the state-space, or -1 for the root state
+		int twist_seq_index;
+		HeuristicCubeState(const std::shared_ptr<HeuristicCubeState> parent, const StateType& cube, const TwistSequence& twist_seq, const int twist_seq_index) : parent(parent), cube(cube), twist_seq(twist_seq), score(Heuristic()(cube)), cost(parent->cost + twist_seq.size()), twist_seq_index(twist_seq_index) {}
+		HeuristicCubeState(const std::shared_ptr<HeuristicCubeState> parent, const StateType&& cube, const TwistSequence& twist_seq, const int twist_seq_index) : parent(parent), cube(cube), twist_seq(twist_seq), score(Heuristic()(cube)), cost(parent->cost + twist_seq.size()), twist_seq_index(twist_seq_index) {}
+		HeuristicCubeState(const std::shared_ptr<HeuristicCubeState> parent, const StateType& cube, const TwistSequence& twist_seq, const int twist_seq_index, const int score) : parent(parent), cube(cube), twist_seq(twist_seq), score(score), cost(parent->cost + twist_seq.size()), twist_seq_index(twist_seq_index) {}
+		HeuristicCubeState(const StateType& cube) : cube(cube), score(Heuristic()(cube)), cost(0), twist_seq_index(-1) {}
 	};
 }
 
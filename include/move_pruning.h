@@ -0,0 +1,52 @@
+#ifndef MOVE_PRUNING_H
+#define MOVE_PRUNING_H
+
+#include <vector>
+#include <cstdint>
+#include "twist.h"
+#include "twist_sequence.h"
+
+namespace ai {
+	//Table built from the set of TwistSequences of a search strategy that specifies which sequences
+	//are redundant directly after another. A sequence is redundant if it undoes the previous sequence,
+	//or if it commutes with the previous sequence and the opposite order is also generated, in which case
+	//only the order in which the sequence with the lower index comes first is kept
+	class MovePruningTable {
+		private:
+			//a twist described by the axis face it rotates around, the layers it rotates counted from 
+			//that face, and the direction of the rotation when viewed from that face
+			struct AxisTwist {
+				cube::Face axis;
+				uint64_t layers;
+				int degrees;
+			};
+
+			int sequence_count;
+
+			//holds the redundancy of every pair of sequences. The entry at (last*sequence_count + next) 
+			//is true if the sequence at index 'next' is redundant after the sequence at index 'last'
+			std::vector<bool> redundant;
+
+			//converts the given twist of a cube of the given size to an AxisTwist
+			static AxisTwist to_axis_twist(const cube::Twist& twist, const int cube_size);
+
+			//returns true if applying 'next' after 'last' returns the cube to its state before 'last'
+			static bool is_inverse(const std::vector<AxisTwist>& last, const std::vector<AxisTwist>& next);
+
+			//returns true if every twist of both sequences rotates around the same axis, which 
+			//means the sequences can be applied in either order
+			static bool commutes(const std::vector<AxisTwist>& last, const std::vector<AxisTwist>& next);
+
+		public:
+			//builds the table for the given TwistSequences, which are applied to cubes of the given size
+			MovePruningTable(const std::vector<TwistSequence>& twist_sequences, const int cube_size);
+
+			//returns true if the sequence at index 'next' doesn't need to be applied to a state reached
+			//by applying the sequence at index 'last'. A negative 'last' index specifies the root state
+			bool is_redundant(const int last, const int next) const {
+				return last >= 0 && redundant[last*sequence_count + next];
+			}
+	};
+}
+
+#endif
@@ -6,6 +6,7 @@
 #include "cube_display.h"
 #include "combined_cube.h"
 #include "ui_manager.h"
+#include "search_limits.h"
 #include <vector>
 #include <memory>
 #include <atomic>
@@ -35,6 +36,12 @@ namespace ui {
 					void start_solution();
 			};
 
+			//memory the searches made at once by a solver thread may use before they are stopped
+			static constexpr std::size_t search_memory_limit = std::size_t(2) << 30;
+
+			//set to stop the solver threads
+			ai::search::CancellationToken solve_cancellation;
+
 			std::mutex executor_mex;
 			std::vector<cube::CombinedCube> sym_cubes;
 			std::vector<std::unique_ptr<CubeDisplay>> cube_displays;
@@ -50,6 +57,11 @@ namespace ui {
 			void setup() override;
 			void solve_cube(const int cube_index);
 
+			//asks every solver thread to stop. The threads return shortly after
+			void cancel_solves() {
+				solve_cancellation = true;
+			}
+
 	};
 }
 
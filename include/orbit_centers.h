@@ -0,0 +1,71 @@
+#ifndef ORBIT_CENTERS_H
+#define ORBIT_CENTERS_H
+
+#include "face.h"
+#include <array>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <iostream>
+
+namespace cube {
+	class Twist;
+
+	//Symbolic representation of one orbit of the centers of a cube, the 24 positions its pieces can be
+	//moved between. The pieces of the other orbits aren't stored, so it is only valid to use twists
+	//whose effect on the rest of the cube is undone, like the 3-cycles of a center commutator
+	class OrbitCenters {
+		public:
+			static constexpr int orbit_size = 24;
+
+			//how the twists of a cube move the pieces of an orbit. It is built once per orbit and shared
+			//by every OrbitCenters of the orbit
+			struct OrbitTable {
+				int size;
+
+				//index each single layer twist moves the piece at each index to. The twist rotating
+				//'layer' of 'face' by 'degrees' has the index (face*size + layer)*2 + (degrees == 90)
+				std::vector<std::array<uint8_t, orbit_size>> twist_destinations;
+
+				//value of the piece at each index when solved, and of the pieces opposite it
+				std::array<uint8_t, orbit_size> solved_values;
+				std::array<uint8_t, orbit_size> opposed_values;
+			};
+
+		private:
+			std::shared_ptr<const OrbitTable> table;
+
+			std::array<uint8_t, orbit_size> pieces;
+
+		public:
+			//constructs the orbit with the given pieces
+			OrbitCenters(const std::shared_ptr<const OrbitTable>& table, const std::array<uint8_t, orbit_size>& pieces) :
+				table(table), pieces(pieces) {}
+
+			const std::shared_ptr<const OrbitTable>& get_table() const {return table;}
+			int get_size() const {return table->size;}
+			int get_piece(const int index) const {return pieces[index];}
+
+			//returns the number of pieces not on the face they belong to when solved
+			int get_unsolved_piece_count() const;
+
+			//returns the number of pieces on the face opposite the face they belong to when solved
+			int get_opposed_piece_count() const;
+
+			//returns the number of bytes used by the orbit
+			std::size_t get_memory_usage() const {return sizeof(OrbitCenters);}
+
+			//performs a rotation on the orbit
+			void rotate(const Twist& twist);
+
+			//writes the pieces of the orbit to the given binary stream
+			void write(std::ostream& stream) const;
+
+			//replaces the pieces of the orbit with pieces written by an orbit sharing its table
+			void read(std::istream& stream);
+
+			bool operator==(const OrbitCenters& orbit) const {return pieces == orbit.pieces;}
+	};
+}
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef ORBIT_EDGES_H
+#define ORBIT_EDGES_H
+
+#include "face.h"
+#include <array>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <iostream>
+
+namespace cube {
+	class Twist;
+
+	//Symbolic representation of one orbit of the wings of a cube, the 24 wings that can be moved between the
+	//positions n and edge_width-1-n of every edge. The orbit is paired once the wings of every edge match the
+	//piece and orientation a shared frame gives the edge. The other wings aren't stored, so it is only valid to
+	//use twists whose effect on the rest of the cube is undone, like conjugated wing swaps
+	class OrbitEdges {
+		public:
+			static constexpr int orbit_size = 24;
+
+			//how the twists of a cube move the wings of an orbit. It is built once per orbit and shared
+			//by every OrbitEdges of the orbit
+			struct OrbitTable {
+				int size;
+
+				//index each single layer twist moves the wing at each index to, with the top bit set if the
+				//wing is flipped on the way. The twist rotating 'layer' of 'face' by 'degrees' has the index
+				//(face*size + layer)*2 + (degrees == 90)
+				std::vector<std::array<uint8_t, orbit_size>> twist_destinations;
+
+				//piece and orientation of the wing at each index once the orbit is paired, encoded like the
+				//edges of a Cube
+				std::array<uint8_t, orbit_size> paired_values;
+			};
+
+		private:
+			std::shared_ptr<const OrbitTable> table;
+
+			//piece and orientation of each wing, encoded like the edges of a Cube
+			std::array<uint8_t, orbit_size> wings;
+
+		public:
+			//constructs the orbit with the given wings
+			OrbitEdges(const std::shared_ptr<const OrbitTable>& table, const std::array<uint8_t, orbit_size>& wings) :
+				table(table), wings(wings) {}
+
+			const std::shared_ptr<const OrbitTable>& get_table() const {return table;}
+			int get_size() const {return table->size;}
+			int get_wing(const int index) const {return wings[index];}
+
+			//returns the number of wings that don't match the piece and orientation of the frame
+			int get_unpaired_wing_count() const;
+
+			//returns the number of bytes used by the orbit
+			std::size_t get_memory_usage() const {return sizeof(OrbitEdges);}
+
+			//performs a rotation on the orbit
+			void rotate(const Twist& twist);
+
+			//writes the wings of the orbit to the given binary stream
+			void write(std::ostream& stream) const;
+
+			//replaces the wings of the orbit with wings written by an orbit sharing its table
+			void read(std::istream& stream);
+
+			bool operator==(const OrbitEdges& orbit) const {return wings == orbit.wings;}
+	};
+}
+
+#endif
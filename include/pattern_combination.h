@@ -0,0 +1,9 @@
+#ifndef PATTERN_COMBINATION_H
+#define PATTERN_COMBINATION_H
+
+namespace ai {
+	//specifies how the distances of the patterns in a pattern database are combined into one estimate
+	enum class PatternCombination {SUM, MAX};
+}
+
+#endif
@@ -3,30 +3,125 @@
 
 #include <vector>
 #include <functional>
+#include <chrono>
+#include <boost/optional.hpp>
 #include "twist.h"
 #include "twist_sequence.h"
+#include "search_limits.h"
 
 namespace ai {
 	namespace search {
+		//configures a breadth-first search that keeps its layers on disk. The children of each layer are written to
+		//'scratch_dir' as sorted runs of at most 'run_memory' bytes, which are merged with the states of the earlier
+		//layers to remove duplicates, so the memory used doesn't grow with the number of states
+		struct ExternalSearchSettings {
+			boost::filesystem::path scratch_dir;
+			std::size_t run_memory = std::size_t(64) << 20;
+
+			ExternalSearchSettings(const boost::filesystem::path& scratch_dir) : scratch_dir(scratch_dir) {}
+		};
+
 		template<typename StateType>
 		std::vector<cube::Twist> trace_twists(const StateType* state);
 
-		//performs a best-first search using the given set of TwistSequences to build the state-space and 
-		//using the 'Heuristic' template paramater to guide the search. Returns a vector of Twist 
-		//objects that led to the state that made 'is_finished' return true
+		//estimates the number of bytes a search uses to store a state and its entry in the set of
+		//seen states, given the root state of the search and the TwistSequences used to build the state-space
+		template<typename StateType, typename CubeType>
+		std::size_t estimate_state_memory(const CubeType& root_state, const std::vector<TwistSequence>& twist_sequences);
+
+		//performs a best-first search using the given set of TwistSequences to build the state-space and
+		//using the 'Heuristic' template paramater to guide the search. Returns the Twist objects that led
+		//to the state that made 'is_finished' return true, or if one of the given limits stopped the search,
+		//the Twist objects that led to the state with the lowest heuristic value found.
+		//
+		//If 'partial_expansion' is true, expanding a state only stores its children with the lowest heuristic
+		//value, and the state is put back in the open list to store the rest later. States are expanded in 
+		//the same order, but far fewer of them are stored when most children are never expanded
+		template<typename CubeType, typename Heuristic>
+		SearchResult best_first_search(
+			const CubeType& root_state,
+			const std::vector<TwistSequence> twist_sequences,
+			const std::function<bool(const CubeType&)>& is_finished,
+			const SearchLimits& limits = SearchLimits(),
+			const bool partial_expansion = false);
+
+		//performs a single pass of a weighted A* search, ordering states by their cost plus 'weight' times
+		//the value of the 'Heuristic' template paramater. States that can't be reached in fewer than 'cost_bound'
+		//twists are pruned. Returns the Twist objects that led to the first state that made 'is_finished'
+		//return true, a partial result if one of the given limits stopped the search, or nothing if the
+		//state-space was exhausted
+		template<typename CubeType, typename Heuristic>
+		boost::optional<SearchResult> weighted_a_star_search(
+			const CubeType& root_state,
+			const std::vector<TwistSequence>& twist_sequences,
+			const std::function<bool(const CubeType&)>& is_finished,
+			const double weight,
+			const int cost_bound,
+			const SearchLimits& limits);
+
+		//performs an anytime weighted A* search. A first solution is found with a best-first search, so it arrives
+		//as fast as it would without refinement. The search is then repeated, starting with 'initial_weight'
+		//and halving the weight each time a shorter solution is found, until 'time_budget' runs out or no shorter
+		//solution exists. A budget of 0 returns the first solution. 'on_improvement' is called with every solution
+		//found, and 'partial_expansion' is passed to the best-first search. Returns the shortest solution found,
+		//or the partial result of the best-first search if one of the given limits stopped it
 		template<typename CubeType, typename Heuristic>
-		std::vector<cube::Twist> best_first_search(
-			const CubeType& root_state, 
-			const std::vector<TwistSequence> twist_sequences, 
-			const std::function<bool(const CubeType&)>& is_finished);
-		
+		SearchResult anytime_weighted_a_star_search(
+			const CubeType& root_state,
+			const std::vector<TwistSequence> twist_sequences,
+			const std::function<bool(const CubeType&)>& is_finished,
+			const std::chrono::milliseconds time_budget,
+			const SearchLimits& limits = SearchLimits(),
+			const std::function<void(const std::vector<cube::Twist>&)>& on_improvement = nullptr,
+			const bool partial_expansion = false,
+			const double initial_weight = 8);
+
+		//returns the moves of the search of an orbit: the given TwistSequences conjugated with every setup of up to
+		//'setup_depth' single layer twists that move the orbit. Sequences that move the orbit the same way are only
+		//kept once, with the shortest setup, and sequences 'is_allowed' returns false for aren't kept
+		template<typename OrbitType>
+		std::vector<TwistSequence> generate_orbit_moves(
+			const OrbitType& orbit,
+			const std::vector<TwistSequence>& twist_sequences,
+			const int setup_depth,
+			const std::function<bool(const TwistSequence&)>& is_allowed = nullptr);
+
+		//performs a best-first search of each of the given orbits with the moves 'generate_moves' returns for its
+		//index, with the orbits searched concurrently on up to 'max_workers' threads. The moves of each orbit must
+		//leave the other orbits alone, so the solutions are joined in any order. Returns the joined solutions, and
+		//the status of the first orbit that wasn't solved. If an orbit's search throws, the exception is rethrown
+		//once every thread has finished
+		template<typename OrbitType, typename Heuristic>
+		SearchResult orbit_search(
+			const std::vector<OrbitType>& orbits,
+			const std::function<std::vector<TwistSequence>(const int)>& generate_moves,
+			const std::function<bool(const OrbitType&)>& is_finished,
+			const int max_workers,
+			const SearchLimits& limits = SearchLimits(),
+			const bool partial_expansion = false);
+
 		//performs a breadth-first search using the given set of TwistSequences to build the state-space.
-		//Returns a vector of Twist objects that led to the state that made 'is_finished' return true
+		//Returns the Twist objects that led to the state that made 'is_finished' return true, or no twists
+		//if one of the given limits stopped the search. If 'external' is set, the search keeps its states
+		//on disk, as described by ExternalSearchSettings
 		template<typename CubeType>
-		std::vector<cube::Twist> breadth_first_search(
-			const CubeType& root_state, 
+		SearchResult breadth_first_search(
+			const CubeType& root_state,
 			const std::vector<TwistSequence> twist_sequences,
-			const std::function<bool(const CubeType&)>& is_finished);
+			const std::function<bool(const CubeType&)>& is_finished,
+			const SearchLimits& limits = SearchLimits(),
+			const boost::optional<ExternalSearchSettings>& external = boost::none);
+
+		//performs the breadth-first search of breadth_first_search with its states on disk. Each layer is a file of
+		//records holding a state, written by the cube's write function, followed by the indices of the TwistSequences
+		//that led to it. The states found so far are kept in a file sorted by state
+		template<typename CubeType>
+		SearchResult external_breadth_first_search(
+			const CubeType& root_state,
+			const std::vector<TwistSequence>& twist_sequences,
+			const std::function<bool(const CubeType&)>& is_finished,
+			const SearchLimits& limits,
+			const ExternalSearchSettings& settings);
 	};
 };
 
@@ -1,8 +1,25 @@
 #include <memory>
 #include <unordered_set>
+#include <unordered_map>
 #include <queue>
+#include <limits>
+#include <algorithm>
+#include <typeinfo>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <exception>
+#include <boost/functional/hash.hpp>
 #include "heuristic_cube_state.h"
 #include "cube_state.h"
+#include "move_pruning.h"
+#include "seen_set.h"
+#include "expansion_batch.h"
+#include "checkpoint.h"
+#include "twist_utils.h"
 
 namespace ai {
 	namespace search {
@@ -22,75 +39,575 @@ namespace ai {
 			return twists;
 		}
 
+		template<typename StateType, typename CubeType>
+		std::size_t estimate_state_memory(const CubeType& root_state, const std::vector<TwistSequence>& twist_sequences) {
+			std::size_t longest_sequence = 0;
+			for (const auto& twist_seq : twist_sequences) {
+				longest_sequence = std::max(longest_sequence, twist_seq.size());
+			}
+
+			//each state holds a copy of the cube and of the twists that led to it, and a second copy
+			//of the cube is held by the set of seen states
+			return sizeof(StateType) + 2*root_state.get_memory_usage() + longest_sequence*sizeof(cube::Twist);
+		}
+
+		//an entry in the open list of a best-first search. With partial expansion, a state that still has
+		//children to push is reinserted with the score of those children as its priority
+		template<typename StateType>
+		struct OpenEntry {
+			int priority;
+			bool reexpansion;
+			std::shared_ptr<StateType> state;
+		};
+
+		//writes the progress of a best-first search to the given stream. The states in the open list and
+		//their ancestors are written parents first, so each state can refer to its parent by its position
+		template<typename StateType, typename CubeType>
+		void write_search_checkpoint(
+			std::ostream& stream,
+			const std::size_t expansions,
+			const std::vector<OpenEntry<StateType>>& open,
+			const SeenSet<CubeType>& seen,
+			const std::shared_ptr<StateType>& closest_state) {
+				std::unordered_map<const StateType*, int32_t> state_ids;
+				std::vector<const StateType*> states;
+				auto add_state = [&state_ids, &states](const StateType* state) {
+					std::vector<const StateType*> new_states;
+					for (auto curr_state = state; curr_state != nullptr && state_ids.count(curr_state) == 0; curr_state = curr_state->parent.get()) {
+						new_states.push_back(curr_state);
+					}
+					for (auto it = new_states.rbegin(); it != new_states.rend(); it++) {
+						state_ids.emplace(*it, states.size());
+						states.push_back(*it);
+					}
+				};
+				for (const auto& entry : open) {
+					add_state(entry.state.get());
+				}
+				add_state(closest_state.get());
+
+				checkpoint::write_value<uint64_t>(stream, expansions);
+				checkpoint::write_value<uint64_t>(stream, states.size());
+				for (const auto state : states) {
+					checkpoint::write_value<int32_t>(stream, state->parent == nullptr ? -1 : state_ids.at(state->parent.get()));
+					checkpoint::write_value<int32_t>(stream, state->twist_seq_index);
+					checkpoint::write_value<int32_t>(stream, state->score);
+					state->cube.write(stream);
+				}
+				checkpoint::write_value<uint64_t>(stream, open.size());
+				for (const auto& entry : open) {
+					checkpoint::write_value<int32_t>(stream, entry.priority);
+					checkpoint::write_value<uint8_t>(stream, entry.reexpansion);
+					checkpoint::write_value<int32_t>(stream, state_ids.at(entry.state.get()));
+				}
+				checkpoint::write_value<uint64_t>(stream, seen.size());
+				for (const auto& cube : seen.get_states()) {
+					cube.write(stream);
+				}
+				checkpoint::write_value<int32_t>(stream, state_ids.at(closest_state.get()));
+		}
+
+		//reads the progress written by write_search_checkpoint into the given variables. Throws
+		//std::runtime_error if the checkpoint is incomplete or doesn't fit the search
+		template<typename StateType, typename CubeType>
+		void read_search_checkpoint(
+			std::istream& stream,
+			const CubeType& root_state,
+			const std::vector<TwistSequence>& twist_sequences,
+			std::size_t& expansions,
+			std::vector<OpenEntry<StateType>>& open,
+			SeenSet<CubeType>& seen,
+			std::shared_ptr<StateType>& closest_state) {
+				auto read_id = [&stream](const std::size_t id_count) {
+					auto id = checkpoint::read_value<int32_t>(stream);
+					if (id < 0 || id >= id_count) {
+						throw std::runtime_error("Checkpoint refers to a state that doesn't exist");
+					}
+					return id;
+				};
+				auto read_cube = [&stream, &root_state]() {
+					CubeType cube(root_state);
+					cube.read(stream);
+					if (!stream) {
+						throw std::runtime_error("Checkpoint ended unexpectedly");
+					}
+					return cube;
+				};
+
+				expansions = checkpoint::read_value<uint64_t>(stream);
+				std::vector<std::shared_ptr<StateType>> states(checkpoint::read_value<uint64_t>(stream));
+				for (std::size_t i = 0; i < states.size(); i++) {
+					auto parent_id = checkpoint::read_value<int32_t>(stream);
+					auto seq_index = checkpoint::read_value<int32_t>(stream);
+					auto score = checkpoint::read_value<int32_t>(stream);
+					auto cube = read_cube();
+					if (parent_id < 0) {
+						states[i] = std::make_shared<StateType>(cube);
+						continue;
+					}
+					if (parent_id >= i || seq_index < 0 || seq_index >= twist_sequences.size()) {
+						throw std::runtime_error("Checkpoint holds an invalid state");
+					}
+					states[i] = std::make_shared<StateType>(states[parent_id], cube, twist_sequences[seq_index], seq_index, score);
+				}
+				open.resize(checkpoint::read_value<uint64_t>(stream));
+				for (auto& entry : open) {
+					entry.priority = checkpoint::read_value<int32_t>(stream);
+					entry.reexpansion = checkpoint::read_value<uint8_t>(stream);
+					entry.state = states[read_id(states.size())];
+				}
+				auto seen_count = checkpoint::read_value<uint64_t>(stream);
+				for (std::size_t i = 0; i < seen_count; i++) {
+					auto cube = read_cube();
+					seen.insert(cube, std::hash<CubeType>()(cube));
+				}
+				closest_state = states[read_id(states.size())];
+		}
+
 		template<typename CubeType, typename Heuristic>
-		std::vector<cube::Twist> best_first_search(
+		SearchResult best_first_search(
 			const CubeType& root_state, 
 			const std::vector<TwistSequence> twist_sequences, 
-			const std::function<bool(const CubeType&)>& is_finished) {
+			const std::function<bool(const CubeType&)>& is_finished,
+			const SearchLimits& limits,
+			const bool partial_expansion) {
 				typedef HeuristicCubeState<CubeType, Heuristic> State;
 
 				if (is_finished(root_state)) {
-					return std::vector<cube::Twist>();	
+					return SearchResult(SearchStatus::SOLVED, std::vector<cube::Twist>());	
+				}
+				std::size_t state_memory = estimate_state_memory<State>(root_state, twist_sequences);
+				std::size_t expansions = 0;
+				MovePruningTable pruning(twist_sequences, root_state.get_size());
+				
+				//the open list is kept as a heap in a vector so its entries can be written to a checkpoint
+				auto entry_compare = [](const OpenEntry<State>& entry1, const OpenEntry<State>& entry2) {
+					return entry1.priority > entry2.priority;
+				};
+				std::vector<OpenEntry<State>> open;
+				auto push_entry = [&open, &entry_compare](const OpenEntry<State>& entry) {
+					open.push_back(entry);
+					std::push_heap(open.begin(), open.end(), entry_compare);
+				};
+				auto closest_state = std::make_shared<State>(root_state);
+				push_entry({closest_state->score, false, closest_state});
+				SeenSet<CubeType> seen;
+				seen.insert(root_state, std::hash<CubeType>()(root_state));
+				ExpansionBatch<CubeType> batch;
+
+				//a checkpoint belongs to the search with the same root state, state-space, heuristic and
+				//expansion mode. A checkpoint that can't be read is ignored and the search starts over
+				boost::optional<boost::filesystem::path> checkpoint_path;
+				std::size_t key = std::hash<CubeType>()(root_state);
+				auto next_checkpoint = std::chrono::steady_clock::now();
+				if (limits.checkpoint) {
+					boost::hash_combine(key, checkpoint::hash_twist_sequences(twist_sequences));
+					boost::hash_combine(key, typeid(Heuristic).hash_code());
+					boost::hash_combine(key, partial_expansion);
+					checkpoint_path = limits.checkpoint->file_path("search", key);
+					next_checkpoint += limits.checkpoint->interval;
+
+					std::ifstream file(checkpoint_path->string(), std::ifstream::binary);
+					if (file) {
+						try {
+							if (!checkpoint::read_header(file, key)) {
+								throw std::runtime_error("Checkpoint belongs to a different search");
+							}
+							std::size_t saved_expansions;
+							std::vector<OpenEntry<State>> saved_open;
+							SeenSet<CubeType> saved_seen;
+							std::shared_ptr<State> saved_closest_state;
+							read_search_checkpoint(file, root_state, twist_sequences, saved_expansions, saved_open, saved_seen, saved_closest_state);
+							expansions = saved_expansions;
+							open = std::move(saved_open);
+							std::make_heap(open.begin(), open.end(), entry_compare);
+							seen = std::move(saved_seen);
+							closest_state = saved_closest_state;
+							std::cout << "Resuming search from " << checkpoint_path->string() << " after " << expansions << " expansions\n";
+						}
+						catch (const std::runtime_error& error) {
+							std::cout << "Ignoring checkpoint " << checkpoint_path->string() << ": " << error.what() << "\n";
+						}
+					}
+				}
+				auto save_checkpoint = [&]() {
+					checkpoint::save(*checkpoint_path, [&](std::ostream& stream) {
+						checkpoint::write_header(stream, key);
+						write_search_checkpoint(stream, expansions, open, seen, closest_state);
+					});
+					next_checkpoint = std::chrono::steady_clock::now() + limits.checkpoint->interval;
+				};
+				
+				while (!open.empty()) {
+					if (++expansions % limits.check_interval == 0) {
+						if (auto status = limits.check(expansions, seen.size()*state_memory)) {
+							//a stopped search keeps its progress so a later run can continue it
+							if (checkpoint_path) {
+								save_checkpoint();
+							}
+							return SearchResult(*status, trace_twists(closest_state.get()));
+						}
+						if (checkpoint_path && std::chrono::steady_clock::now() >= next_checkpoint) {
+							save_checkpoint();
+						}
+					}
+					std::pop_heap(open.begin(), open.end(), entry_compare);
+					auto entry = open.back();
+					open.pop_back();
+					auto& curr_state = entry.state;
+					batch.expand(curr_state->cube, curr_state->twist_seq_index, twist_sequences, pruning);
+					if (partial_expansion) {
+						batch.find_unseen(seen);
+					}
+					else {
+						batch.filter_seen(seen);
+					}
+					batch.template score_unseen<Heuristic>();
+
+					//with partial expansion, only the unseen children with the lowest score are pushed.
+					//The state is reinserted to push the remaining children once their score is the
+					//lowest in the open list. Every child is checked against the goal the first time its
+					//parent is expanded
+					int push_bound = std::numeric_limits<int>::max();
+					if (partial_expansion) {
+						push_bound = entry.priority;
+						int lowest_score = std::numeric_limits<int>::max();
+						for (const int child : batch.unseen) {
+							lowest_score = std::min(lowest_score, batch.scores[child]);
+						}
+						push_bound = std::max(push_bound, lowest_score);
+					}
+					int deferred_score = std::numeric_limits<int>::max();
+					for (const int child : batch.unseen) {
+						int seq_index = batch.twist_seq_indices[child];
+						if (!entry.reexpansion && is_finished(batch.children[child])) {
+							auto child_state = std::make_shared<State>(curr_state, batch.children[child], 
+									twist_sequences[seq_index], seq_index, batch.scores[child]);
+							if (checkpoint_path) {
+								checkpoint::remove(*checkpoint_path);
+							}
+							return SearchResult(SearchStatus::SOLVED, trace_twists(child_state.get()));
+						}
+						if (batch.scores[child] > push_bound) {
+							deferred_score = std::min(deferred_score, batch.scores[child]);
+							continue;
+						}
+						if (partial_expansion && !seen.insert(batch.children[child], batch.hashes[child])) {
+							continue;
+						}
+						auto child_state = std::make_shared<State>(curr_state, batch.children[child], 
+								twist_sequences[seq_index], seq_index, batch.scores[child]);
+						if (child_state->score < closest_state->score) {
+							closest_state = child_state;
+						}
+						push_entry({child_state->score, false, child_state});
+					}
+					if (deferred_score != std::numeric_limits<int>::max()) {
+						push_entry({deferred_score, true, curr_state});
+					}
+				}
+
+				if (checkpoint_path) {
+					checkpoint::remove(*checkpoint_path);
 				}
-				auto state_compare = [](const std::shared_ptr<State> state1, const std::shared_ptr<State> state2) {
-					return state1->score > state2->score;
+				throw std::invalid_argument("The given cube couldn't be solved");
+		}
+
+		template<typename CubeType, typename Heuristic>
+		boost::optional<SearchResult> weighted_a_star_search(
+			const CubeType& root_state, 
+			const std::vector<TwistSequence>& twist_sequences, 
+			const std::function<bool(const CubeType&)>& is_finished,
+			const double weight,
+			const int cost_bound,
+			const SearchLimits& limits) {
+				typedef HeuristicCubeState<CubeType, Heuristic> State;
+
+				std::size_t state_memory = estimate_state_memory<State>(root_state, twist_sequences);
+				std::size_t expansions = 0;
+				MovePruningTable pruning(twist_sequences, root_state.get_size());
+
+				//ties are broken in favor of the state closest to the goal
+				auto state_compare = [weight](const std::shared_ptr<State> state1, const std::shared_ptr<State> state2) {
+					double priority1 = state1->cost + weight*state1->score;
+					double priority2 = state2->cost + weight*state2->score;
+					return priority1 > priority2 || (priority1 == priority2 && state1->score > state2->score);
 				};
 				std::priority_queue<
 					std::shared_ptr<State>, 
 					std::vector<std::shared_ptr<State>>, 
 					decltype(state_compare)> open(state_compare);
-				open.push(std::make_shared<State>(root_state));
-				std::unordered_set<CubeType> seen = {root_state};
-				
+				auto closest_state = std::make_shared<State>(root_state);
+				open.push(closest_state);
+				//maps each state seen to the lowest cost it has been reached with. States reached
+				//with a lower cost than before are reopened
+				std::unordered_map<CubeType, int> seen;
+				seen.emplace(root_state, 0);
+
 				while (!open.empty()) {
+					if (++expansions % limits.check_interval == 0) {
+						if (auto status = limits.check(expansions, seen.size()*state_memory)) {
+							return SearchResult(*status, trace_twists(closest_state.get()));
+						}
+					}
 					auto curr_state = open.top();
 					open.pop();
-					for (const auto& twist_seq : twist_sequences) {
+					if (seen.at(curr_state->cube) < curr_state->cost) {
+						continue;
+					}
+					for (int seq_index = 0; seq_index < twist_sequences.size(); seq_index++) {
+						if (pruning.is_redundant(curr_state->twist_seq_index, seq_index)) {
+							continue;
+						}
+						const auto& twist_seq = twist_sequences[seq_index];
+						int child_cost = curr_state->cost + twist_seq.size();
+						if (child_cost >= cost_bound) {
+							continue;
+						}
 						CubeType child_cube(curr_state->cube);
 						for (const auto& twist : twist_seq) {
 							child_cube.rotate(twist);
 						}
-						if (!seen.count(child_cube)) {
-							seen.insert(child_cube);
-							auto child_state = std::make_shared<State>(curr_state, std::move(child_cube), twist_seq);
+						auto seen_it = seen.find(child_cube);
+						if (seen_it == seen.end() || seen_it->second > child_cost) {
+							if (seen_it == seen.end()) {
+								seen.emplace(child_cube, child_cost);
+							}
+							else {
+								seen_it->second = child_cost;
+							}
+							auto child_state = std::make_shared<State>(curr_state, std::move(child_cube), twist_seq, seq_index);
 							if (is_finished(child_state->cube)) {
-								return trace_twists(child_state.get());
+								return SearchResult(SearchStatus::SOLVED, trace_twists(child_state.get()));
+							}
+							if (child_state->score < closest_state->score) {
+								closest_state = child_state;
 							}
 							open.push(child_state);
 						}
 					}
 				}
 
-				throw std::invalid_argument("The given cube couldn't be solved");
+				return boost::none;
+		}
+
+		template<typename CubeType, typename Heuristic>
+		SearchResult anytime_weighted_a_star_search(
+			const CubeType& root_state, 
+			const std::vector<TwistSequence> twist_sequences, 
+			const std::function<bool(const CubeType&)>& is_finished,
+			const std::chrono::milliseconds time_budget,
+			const SearchLimits& limits,
+			const std::function<void(const std::vector<cube::Twist>&)>& on_improvement,
+			const bool partial_expansion,
+			const double initial_weight) {
+				//the first solution is searched for until it is found or the limits stop the search. 
+				//The time budget only applies to the search for shorter solutions
+				auto solution = best_first_search<CubeType, Heuristic>(root_state, twist_sequences, is_finished, limits, partial_expansion);
+				if (!solution.solved()) {
+					return solution;
+				}
+				if (on_improvement) {
+					on_improvement(solution.twists);
+				}
+				if (time_budget.count() <= 0) {
+					return solution;
+				}
+				SearchLimits refinement_limits(limits);
+				auto deadline = std::chrono::steady_clock::now() + time_budget;
+				if (!refinement_limits.deadline || *refinement_limits.deadline > deadline) {
+					refinement_limits.deadline = deadline;
+				}
+				
+				//every pass prunes states that can't beat the current solution, so a pass that ends 
+				//without a solution means no shorter solution exists. A pass stopped by the limits
+				//ends the refinement and leaves the current solution in place
+				double weight = std::max(1.0, initial_weight);
+				while (!refinement_limits.check()) {
+					auto improved_solution = weighted_a_star_search<CubeType, Heuristic>(root_state, twist_sequences, is_finished,
+							weight, solution.twists.size(), refinement_limits);
+					if (!improved_solution || !improved_solution->solved()) {
+						break;
+					}
+					solution = std::move(*improved_solution);
+					if (on_improvement) {
+						on_improvement(solution.twists);
+					}
+					weight = std::max(1.0, weight/2);
+				}
+
+				return solution;
+		}
+
+		template<typename OrbitType>
+		std::vector<TwistSequence> generate_orbit_moves(
+			const OrbitType& orbit,
+			const std::vector<TwistSequence>& twist_sequences,
+			const int setup_depth,
+			const std::function<bool(const TwistSequence&)>& is_allowed) {
+				//the moves are compared by the index each moves the piece at each index to
+				std::array<uint8_t, OrbitType::orbit_size> indices;
+				for (int i = 0; i < OrbitType::orbit_size; i++) {
+					indices[i] = i;
+				}
+				OrbitType unmoved(orbit.get_table(), indices);
+
+				//twists that move the orbit, from which the setups are built
+				std::vector<cube::Twist> setup_twists;
+				for (const auto axis : TwistUtils::AXIS_FACES) {
+					for (int layer = 0; layer < orbit.get_size(); layer++) {
+						for (const int degrees : TwistUtils::DEGREES) {
+							OrbitType moved(unmoved);
+							moved.rotate(cube::Twist(degrees, axis, layer, false));
+							if (!(moved == unmoved)) {
+								setup_twists.push_back(cube::Twist(degrees, axis, layer, false));
+							}
+						}
+					}
+				}
+
+				//the setups are extended one twist at a time, and each setup is only kept if it moves the
+				//orbit differently from every shorter setup
+				std::vector<TwistSequence> setups = {TwistSequence()};
+				std::vector<OrbitType> seen_setups = {unmoved};
+				for (int begin = 0, depth = 0; depth < setup_depth; depth++) {
+					int end = setups.size();
+					for (int i = begin; i < end; i++) {
+						for (const auto& twist : setup_twists) {
+							TwistSequence setup(setups[i]);
+							setup.push_back(twist);
+							OrbitType moved(unmoved);
+							for (const auto& setup_twist : setup) {
+								moved.rotate(setup_twist);
+							}
+							if (std::find(seen_setups.begin(), seen_setups.end(), moved) == seen_setups.end()) {
+								seen_setups.push_back(moved);
+								setups.push_back(setup);
+							}
+						}
+					}
+					begin = end;
+				}
+
+				std::vector<TwistSequence> moves;
+				std::vector<OrbitType> seen_moves;
+				for (const auto& setup : setups) {
+					for (const auto& twist_seq : twist_sequences) {
+						TwistSequence move(setup);
+						move.insert(move.end(), twist_seq.begin(), twist_seq.end());
+						auto undo_setup = TwistUtils::invert(setup);
+						move.insert(move.end(), undo_setup.begin(), undo_setup.end());
+						OrbitType moved(unmoved);
+						for (const auto& twist : move) {
+							moved.rotate(twist);
+						}
+						if (std::find(seen_moves.begin(), seen_moves.end(), moved) == seen_moves.end() && (!is_allowed || is_allowed(move))) {
+							seen_moves.push_back(moved);
+							moves.push_back(move);
+						}
+					}
+				}
+
+				return moves;
+		}
+
+		template<typename OrbitType, typename Heuristic>
+		SearchResult orbit_search(
+			const std::vector<OrbitType>& orbits,
+			const std::function<std::vector<TwistSequence>(const int)>& generate_moves,
+			const std::function<bool(const OrbitType&)>& is_finished,
+			const int max_workers,
+			const SearchLimits& limits,
+			const bool partial_expansion) {
+				//each worker takes the next orbit that hasn't been searched. Orbit searches don't save 
+				//checkpoints, since they would be written concurrently
+				SearchLimits orbit_limits(limits);
+				orbit_limits.checkpoint = boost::none;
+				std::vector<SearchResult> results(orbits.size(), SearchResult(SearchStatus::SOLVED, std::vector<cube::Twist>()));
+				std::vector<std::exception_ptr> errors(orbits.size());
+				std::atomic<int> next_orbit(0);
+				auto search_orbits = [&]() {
+					for (int orbit = next_orbit++; orbit < orbits.size(); orbit = next_orbit++) {
+						try {
+							results[orbit] = best_first_search<OrbitType, Heuristic>(orbits[orbit], generate_moves(orbit), is_finished, 
+									orbit_limits, partial_expansion);
+						}
+						catch (...) {
+							errors[orbit] = std::current_exception();
+						}
+					}
+				};
+				int worker_count = std::max(1, std::min<int>(max_workers, orbits.size()));
+				std::vector<std::thread> workers;
+				for (int i = 1; i < worker_count; i++) {
+					workers.emplace_back(search_orbits);
+				}
+				search_orbits();
+				for (auto& worker : workers) {
+					worker.join();
+				}
+				for (const auto& error : errors) {
+					if (error) {
+						std::rethrow_exception(error);
+					}
+				}
+
+				//the twists of orbits that weren't solved still lead to their closest state
+				SearchResult joined(SearchStatus::SOLVED, std::vector<cube::Twist>());
+				for (const auto& result : results) {
+					joined.twists.insert(joined.twists.end(), result.twists.begin(), result.twists.end());
+					if (!result.solved() && joined.solved()) {
+						joined.status = result.status;
+					}
+				}
+
+				return joined;
 		}
 
 		template<typename CubeType>
-		std::vector<cube::Twist> breadth_first_search(
+		SearchResult breadth_first_search(
 			const CubeType& root_state,
 			const std::vector<TwistSequence> twist_sequences,
-			const std::function<bool(const CubeType&)>& is_finished) {
+			const std::function<bool(const CubeType&)>& is_finished,
+			const SearchLimits& limits,
+			const boost::optional<ExternalSearchSettings>& external) {
 				typedef CubeState<CubeType> State;
 
+				if (external) {
+					return external_breadth_first_search(root_state, twist_sequences, is_finished, limits, *external);
+				}
 				if (is_finished(root_state)) {
-					return std::vector<cube::Twist>();	
+					return SearchResult(SearchStatus::SOLVED, std::vector<cube::Twist>());	
 				}
+				std::size_t state_memory = estimate_state_memory<State>(root_state, twist_sequences);
+				std::size_t expansions = 0;
+				MovePruningTable pruning(twist_sequences, root_state.get_size());
 				std::queue<std::shared_ptr<State>> open;
 				open.push(std::make_shared<State>(root_state));
 				std::unordered_set<CubeType> seen = {root_state};
 				
 				while (!open.empty()) {
+					if (++expansions % limits.check_interval == 0) {
+						if (auto status = limits.check(expansions, seen.size()*state_memory)) {
+							return SearchResult(*status, std::vector<cube::Twist>());
+						}
+					}
 					auto curr_state = open.front();
 					open.pop();
-					for (const auto& twist_seq : twist_sequences) {
+					for (int seq_index = 0; seq_index < twist_sequences.size(); seq_index++) {
+						if (pruning.is_redundant(curr_state->twist_seq_index, seq_index)) {
+							continue;
+						}
+						const auto& twist_seq = twist_sequences[seq_index];
 						CubeType child_cube(curr_state->cube);
 						for (const auto& twist : twist_seq) {
 							child_cube.rotate(twist);
 						}
 						if (!seen.count(child_cube)) {
 							seen.insert(child_cube);
-							auto child_state = std::make_shared<State>(curr_state, std::move(child_cube), twist_seq);
+							auto child_state = std::make_shared<State>(curr_state, std::move(child_cube), twist_seq, seq_index);
 							if (is_finished(child_state->cube)) {
-								return trace_twists(child_state.get());
+								return SearchResult(SearchStatus::SOLVED, trace_twists(child_state.get()));
 							}
 							open.push(child_state);
 						}
@@ -99,5 +616,208 @@ namespace ai {
 
 				throw std::invalid_argument("The given cube couldn't be solved");
 		}
+
+		//reads the records of a file of records of the same length, one record at a time
+		class RecordReader {
+			private:
+				std::ifstream file;
+				std::string record;
+				bool has_record;
+
+			public:
+				RecordReader(const boost::filesystem::path& file_path, const std::size_t record_length) : 
+					file(file_path.string(), std::ifstream::binary), record(record_length, '\0') {
+					next();
+				}
+
+				//returns false once every record has been read
+				bool valid() const {return has_record;}
+
+				const std::string& get() const {return record;}
+
+				void next() {
+					has_record = static_cast<bool>(file.read(&record[0], record.size()));
+				}
+		};
+
+		template<typename CubeType>
+		SearchResult external_breadth_first_search(
+			const CubeType& root_state,
+			const std::vector<TwistSequence>& twist_sequences,
+			const std::function<bool(const CubeType&)>& is_finished,
+			const SearchLimits& limits,
+			const ExternalSearchSettings& settings) {
+				if (is_finished(root_state)) {
+					return SearchResult(SearchStatus::SOLVED, std::vector<cube::Twist>());	
+				}
+
+				//the files of the search are kept in a directory of their own, which is removed when the search ends
+				struct ScratchDirectory {
+					boost::filesystem::path path;
+
+					~ScratchDirectory() {
+						boost::system::error_code error;
+						boost::filesystem::remove_all(path, error);
+					}
+				} scratch {settings.scratch_dir/boost::filesystem::unique_path("bfs-%%%%-%%%%-%%%%")};
+				boost::filesystem::create_directories(scratch.path);
+
+				auto encode = [](const CubeType& cube) {
+					std::ostringstream stream;
+					cube.write(stream);
+					return stream.str();
+				};
+				const std::size_t state_length = encode(root_state).size();
+				auto same_state = [state_length](const std::string& lhs, const std::string& rhs) {
+					return lhs.compare(0, state_length, rhs, 0, state_length) == 0;
+				};
+				auto state_less = [state_length](const std::string& lhs, const std::string& rhs) {
+					return lhs.compare(0, state_length, rhs, 0, state_length) < 0;
+				};
+				auto get_index = [state_length](const std::string& record, const int i) {
+					uint32_t index;
+					std::memcpy(&index, record.data() + state_length + i*sizeof(uint32_t), sizeof(uint32_t));
+					return index;
+				};
+
+				//the root is the only state of the first layer, and the only state found so far
+				auto seen_path = scratch.path/"seen_0.bin";
+				auto layer_path = scratch.path/"layer_0.bin";
+				for (const auto& path : {seen_path, layer_path}) {
+					std::ofstream file(path.string(), std::ofstream::binary);
+					file << encode(root_state);
+				}
+
+				MovePruningTable pruning(twist_sequences, root_state.get_size());
+				std::size_t expansions = 0;
+				std::size_t layer_size = 1;
+				for (int depth = 1; layer_size > 0; depth++) {
+					//the children of the layer are sorted in runs by their state, and by their TwistSequences
+					//among children with the same state, so the searches are repeatable
+					std::size_t record_length = state_length + depth*sizeof(uint32_t);
+					std::size_t run_capacity = std::max<std::size_t>(1, settings.run_memory/(record_length + sizeof(std::string)));
+					std::vector<std::string> run;
+					std::vector<boost::filesystem::path> run_paths;
+					auto write_run = [&]() {
+						std::sort(run.begin(), run.end());
+						run_paths.push_back(scratch.path/("run_" + std::to_string(depth) + "_" + std::to_string(run_paths.size()) + ".bin"));
+						std::ofstream file(run_paths.back().string(), std::ofstream::binary);
+						for (const auto& record : run) {
+							file.write(record.data(), record.size());
+						}
+						if (!file) {
+							throw std::runtime_error("Couldn't write " + run_paths.back().string());
+						}
+						run.clear();
+					};
+
+					for (RecordReader layer(layer_path, record_length - sizeof(uint32_t)); layer.valid(); layer.next()) {
+						if (++expansions % limits.check_interval == 0) {
+							if (auto status = limits.check(expansions, run.size()*(record_length + sizeof(std::string)))) {
+								return SearchResult(*status, std::vector<cube::Twist>());
+							}
+						}
+						const auto& record = layer.get();
+						CubeType cube(root_state);
+						std::istringstream stream(record);
+						cube.read(stream);
+						int last_index = depth == 1 ? -1 : get_index(record, depth-2);
+						for (int seq_index = 0; seq_index < twist_sequences.size(); seq_index++) {
+							if (pruning.is_redundant(last_index, seq_index)) {
+								continue;
+							}
+							CubeType child_cube(cube);
+							for (const auto& twist : twist_sequences[seq_index]) {
+								child_cube.rotate(twist);
+							}
+							std::string child_record = encode(child_cube);
+							child_record.append(record, state_length, std::string::npos);
+							uint32_t index = seq_index;
+							child_record.append(reinterpret_cast<const char*>(&index), sizeof(index));
+							if (is_finished(child_cube)) {
+								std::vector<cube::Twist> twists;
+								for (int i = 0; i < depth; i++) {
+									const auto& twist_seq = twist_sequences[get_index(child_record, i)];
+									twists.insert(twists.end(), twist_seq.begin(), twist_seq.end());
+								}
+								return SearchResult(SearchStatus::SOLVED, twists);
+							}
+							run.push_back(std::move(child_record));
+							if (run.size() == run_capacity) {
+								write_run();
+							}
+						}
+					}
+					if (!run.empty()) {
+						write_run();
+					}
+					std::vector<std::string>().swap(run);
+
+					//the runs are merged, keeping the first child of every state, and children whose state
+					//was found in an earlier layer are dropped. The rest are the next layer
+					auto next_seen_path = scratch.path/("seen_" + std::to_string(depth) + ".bin");
+					auto next_layer_path = scratch.path/("layer_" + std::to_string(depth) + ".bin");
+					{
+						std::ofstream next_seen(next_seen_path.string(), std::ofstream::binary);
+						std::ofstream next_layer(next_layer_path.string(), std::ofstream::binary);
+						std::vector<std::unique_ptr<RecordReader>> runs;
+						for (const auto& run_path : run_paths) {
+							runs.push_back(std::make_unique<RecordReader>(run_path, record_length));
+						}
+						auto run_compare = [&runs](const int lhs, const int rhs) {
+							return runs[rhs]->get() < runs[lhs]->get() || (runs[lhs]->get() == runs[rhs]->get() && rhs < lhs);
+						};
+						std::priority_queue<int, std::vector<int>, decltype(run_compare)> open_runs(run_compare);
+						for (int run = 0; run < runs.size(); run++) {
+							if (runs[run]->valid()) {
+								open_runs.push(run);
+							}
+						}
+
+						RecordReader seen(seen_path, state_length);
+						std::string last_child;
+						layer_size = 0;
+						while (!open_runs.empty()) {
+							int run = open_runs.top();
+							open_runs.pop();
+							std::string child = runs[run]->get();
+							runs[run]->next();
+							if (runs[run]->valid()) {
+								open_runs.push(run);
+							}
+							if (!last_child.empty() && same_state(last_child, child)) {
+								continue;
+							}
+							last_child = child;
+							while (seen.valid() && state_less(seen.get(), child)) {
+								next_seen.write(seen.get().data(), state_length);
+								seen.next();
+							}
+							if (seen.valid() && same_state(seen.get(), child)) {
+								continue;
+							}
+							next_seen.write(child.data(), state_length);
+							next_layer.write(child.data(), child.size());
+							layer_size++;
+						}
+						while (seen.valid()) {
+							next_seen.write(seen.get().data(), state_length);
+							seen.next();
+						}
+						if (!next_seen || !next_layer) {
+							throw std::runtime_error("Couldn't write layer " + std::to_string(depth) + " of the search");
+						}
+					}
+					for (const auto& path : run_paths) {
+						boost::filesystem::remove(path);
+					}
+					boost::filesystem::remove(seen_path);
+					boost::filesystem::remove(layer_path);
+					seen_path = next_seen_path;
+					layer_path = next_layer_path;
+				}
+
+				throw std::invalid_argument("The given cube couldn't be solved");
+		}
 	}
 }
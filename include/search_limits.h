@@ -0,0 +1,79 @@
+#ifndef SEARCH_LIMITS_H
+#define SEARCH_LIMITS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <ostream>
+#include <vector>
+#include <boost/optional.hpp>
+#include "twist.h"
+#include "checkpoint.h"
+
+namespace ai {
+	namespace search {
+		//specifies why a search stopped
+		enum class SearchStatus {SOLVED, CANCELLED, TIMED_OUT, EXPANSION_LIMIT_REACHED, MEMORY_LIMIT_REACHED};
+
+		//set from any thread to ask the searches watching it to stop
+		typedef std::atomic<bool> CancellationToken;
+
+		//bounds the resources a search may use. The bounds are checked every 'check_interval'
+		//expansions, so a search may slightly overshoot them
+		struct SearchLimits {
+			//maximum number of states a single search may expand
+			std::size_t max_expansions = std::numeric_limits<std::size_t>::max();
+
+			//maximum number of bytes the states stored by a single search may use
+			std::size_t max_memory = std::numeric_limits<std::size_t>::max();
+
+			//point in time at which searches are stopped
+			boost::optional<std::chrono::steady_clock::time_point> deadline;
+
+			//searches are stopped once this token is set
+			const CancellationToken* cancellation_token = nullptr;
+
+			//number of expansions made between checks of the limits
+			std::size_t check_interval = 8;
+
+			//if set, searches periodically save their progress and resume from the progress
+			//saved by an earlier process
+			boost::optional<CheckpointSettings> checkpoint;
+
+			//returns the reason a search that has made the given number of expansions and uses the
+			//given number of bytes needs to stop, or nothing if it can continue
+			boost::optional<SearchStatus> check(const std::size_t expansions = 0, const std::size_t memory_usage = 0) const {
+				if (cancellation_token != nullptr && cancellation_token->load(std::memory_order_relaxed)) {
+					return SearchStatus::CANCELLED;
+				}
+				if (deadline && std::chrono::steady_clock::now() > *deadline) {
+					return SearchStatus::TIMED_OUT;
+				}
+				if (expansions >= max_expansions) {
+					return SearchStatus::EXPANSION_LIMIT_REACHED;
+				}
+				if (memory_usage >= max_memory) {
+					return SearchStatus::MEMORY_LIMIT_REACHED;
+				}
+
+				return boost::none;
+			}
+		};
+
+		//the outcome of a search. If the search was stopped before it was solved, 'twists' leads
+		//to the state closest to the goal that was found
+		struct SearchResult {
+			SearchStatus status;
+			std::vector<cube::Twist> twists;
+
+			SearchResult(const SearchStatus status, const std::vector<cube::Twist>& twists) : status(status), twists(twists) {}
+
+			bool solved() const {return status == SearchStatus::SOLVED;}
+		};
+
+		std::ostream& operator<<(std::ostream& stream, const SearchStatus& status);
+	}
+}
+
+#endif
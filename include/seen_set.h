@@ -0,0 +1,101 @@
+#ifndef SEEN_SET_H
+#define SEEN_SET_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace ai {
+	//Open-addressing hash set used by the searches to track the states they have seen. Hashes are
+	//computed by the caller and stored next to each entry, so a state is never hashed twice and most
+	//failed probes are rejected without comparing states. The slot a hash maps to can be prefetched 
+	//ahead of a probe
+	template<typename StateType>
+	class SeenSet {
+		private:
+			static constexpr std::size_t empty_slot = std::numeric_limits<std::size_t>::max();
+
+			//a slot of the table holds the hash of a state and the index of that state in 'states'
+			struct Slot {
+				std::size_t hash;
+				std::size_t index = empty_slot;
+			};
+
+			std::vector<Slot> slots;
+			std::vector<StateType> states;
+
+			//number of bits of a hash used to pick a slot
+			int slot_bits;
+
+			//maps a hash to the first slot probed for it
+			std::size_t home_slot(const std::size_t hash) const {
+				return (hash * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - slot_bits);
+			}
+
+			//returns the slot holding the given state, or the empty slot it would be inserted into
+			std::size_t find_slot(const StateType& state, const std::size_t hash) const {
+				std::size_t mask = slots.size() - 1;
+				for (std::size_t slot = home_slot(hash); ; slot = (slot + 1) & mask) {
+					const Slot& curr_slot = slots[slot];
+					if (curr_slot.index == empty_slot || (curr_slot.hash == hash && states[curr_slot.index] == state)) {
+						return slot;
+					}
+				}
+			}
+
+			//doubles the number of slots, keeping the load factor at or below one half
+			void grow() {
+				std::vector<Slot> old_slots(slots.size()*2);
+				old_slots.swap(slots);
+				slot_bits++;
+				std::size_t mask = slots.size() - 1;
+				for (const auto& old_slot : old_slots) {
+					if (old_slot.index != empty_slot) {
+						std::size_t slot = home_slot(old_slot.hash);
+						while (slots[slot].index != empty_slot) {
+							slot = (slot + 1) & mask;
+						}
+						slots[slot] = old_slot;
+					}
+				}
+			}
+
+		public:
+			SeenSet() : slots(std::size_t(1) << 10), slot_bits(10) {}
+
+			//hints that the given hash will soon be probed for
+			void prefetch(const std::size_t hash) const {
+				__builtin_prefetch(&slots[home_slot(hash)]);
+			}
+
+			//returns true if the given state, which has the given hash, is in the set
+			bool contains(const StateType& state, const std::size_t hash) const {
+				return slots[find_slot(state, hash)].index != empty_slot;
+			}
+
+			//adds the given state, which has the given hash, to the set. Returns false if
+			//the state was already in the set
+			bool insert(const StateType& state, const std::size_t hash) {
+				std::size_t slot = find_slot(state, hash);
+				if (slots[slot].index != empty_slot) {
+					return false;
+				}
+				slots[slot].hash = hash;
+				slots[slot].index = states.size();
+				states.push_back(state);
+				if (states.size()*2 > slots.size()) {
+					grow();
+				}
+
+				return true;
+			}
+
+			std::size_t size() const {return states.size();}
+
+			//returns the states in the set, in the order they were inserted
+			const std::vector<StateType>& get_states() const {return states;}
+	};
+}
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef STAGE_TABLE_H
+#define STAGE_TABLE_H
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include "twist_sequence.h"
+#include "cube.h"
+
+namespace ai {
+	//an integer describing the part of a cube that matters to a stage of the ThreeCubeSolver. The value of the
+	//coordinate after any move of the stage must only depend on its value before the move. Values are ranks,
+	//with every value below the count reachable, so the states of a stage index its tables directly
+	struct Coordinate {
+		//number of values of the coordinate
+		int count;
+
+		//returns the value of the coordinate of a reduced cube
+		std::function<int(const cube::Cube&)> get;
+
+		//returns a 3x3 cube with the given value of the coordinate
+		std::function<cube::Cube(const int)> set;
+	};
+
+	//Tables for moving a reduced cube through one stage of the ThreeCubeSolver. A state of the stage is a value of
+	//each of its coordinates, and its index is the values of the coordinates read as the digits of a number, the
+	//first coordinate being the most significant. The move tables hold the value of every coordinate after every
+	//move, so moves are made on states without a cube. The pruning table holds the distance of every state from the
+	//solved state modulo 3, in 2 bits. The distances of neighbouring states differ by at most 1, so a move to a state
+	//whose distance is one less modulo 3 always brings the cube closer, and the stage is solved by following such
+	//moves downhill. The move tables are built when the table is loaded, and the pruning table is saved to a file
+	//that is memory-mapped
+	class StageTable {
+		private:
+			//identifies files written by this version of the program
+			static constexpr uint32_t magic = 0x4C425453;
+			static constexpr uint32_t version = 2;
+
+			//number of bits holding the distance of each state
+			static constexpr uint32_t state_bits = 2;
+
+			//number of bytes of the pruning table compressed together in a compressed file
+			static constexpr uint32_t block_length = 1 << 16;
+
+			//distance of states that can't be reached from the solved state
+			static constexpr int unreached = 3;
+
+			//header at the start of a file. The pruning table follows it, either as it is, or split into blocks
+			//of 'block_length' bytes that are compressed with zlib. A compressed table starts with the offset of
+			//every block from the end of the offsets, and of the end of the last block, so each block can be found
+			//without decompressing the ones before it. The checksum is the CRC-32 of the uncompressed table
+			struct FileHeader {
+				uint32_t magic;
+				uint32_t version;
+				uint32_t stage;
+				uint32_t state_bits;
+				uint64_t key;
+				uint64_t state_count;
+
+				//0 if the table isn't compressed
+				uint32_t block_length;
+				uint32_t checksum;
+			};
+			static constexpr std::size_t header_length = 6*sizeof(uint32_t) + 2*sizeof(uint64_t);
+
+			//number of the stage, stored in the header to catch tables loaded for the wrong stage
+			int stage;
+
+			//whether the file is written with the table compressed
+			bool compressed;
+
+			std::vector<Coordinate> coordinates;
+			std::vector<TwistSequence> moves;
+
+			//value of each coordinate after each move, at the index value*moves.size() + move
+			std::vector<std::vector<uint32_t>> move_tables;
+
+			//value of a unit of each coordinate in the index of a state
+			std::vector<uint64_t> places;
+
+			uint64_t state_count;
+			uint64_t solved_state;
+
+			boost::iostreams::mapped_file_source file;
+
+			//the pruning table when it is loaded from a compressed file
+			std::vector<uint8_t> decompressed_table;
+
+			//the pruning table, 4 states in every byte, in the memory-mapped file or 'decompressed_table'
+			const uint8_t* distances;
+
+			//returns the value of the coordinate after each move for each of its values
+			std::vector<uint32_t> generate_move_table(const Coordinate& coordinate) const;
+
+			//returns the index of the state of the given cube
+			uint64_t get_state(const cube::Cube& cube) const;
+
+			//writes the index of the state each move leads to from the given state to 'children', which
+			//has an element for every move
+			void find_children(const uint64_t state, std::vector<uint64_t>& children) const;
+
+			//returns the distance of the given state modulo 3, or 'unreached'
+			int get_distance(const uint64_t state) const {return (distances[state/4] >> (state%4*2)) & 3;}
+
+			//computes the distance of every state with a breadth-first search from the solved state, and writes the
+			//pruning table to the given path
+			void generate(const boost::filesystem::path& file_path, const uint64_t key) const;
+
+			//loads the pruning table from the given path. Returns false if the file doesn't exist, was written
+			//for another stage, other coordinates or other moves, or doesn't match its checksum
+			bool load(const boost::filesystem::path& file_path, const uint64_t key);
+
+		public:
+			//loads the table of the given stage, with the given coordinates and moves, from the given path. If the
+			//file can't be loaded, the pruning table is generated and saved first, compressed if 'compressed' is
+			//set. Compressed tables take less space, but are decompressed into memory rather than memory-mapped.
+			//Tables are usually loaded through the StageTableRegistry, so each one is only loaded once
+			StageTable(const boost::filesystem::path& file_path, const int stage, const std::vector<Coordinate>& coordinates,
+					const std::vector<TwistSequence>& moves, const bool compressed = false);
+
+			//returns the moves that bring the given reduced cube to the solved state of the stage. Throws
+			//std::runtime_error if the state can't be reached with the moves of the stage
+			TwistSequence solve(const cube::Cube& cube) const;
+	};
+}
+
+#endif
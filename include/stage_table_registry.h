@@ -0,0 +1,44 @@
+#ifndef STAGE_TABLE_REGISTRY_H
+#define STAGE_TABLE_REGISTRY_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <functional>
+#include <boost/filesystem.hpp>
+#include "stage_table.h"
+
+namespace ai {
+	//Process-wide registry of the StageTables, keyed by the path of their files. A table is loaded, or generated,
+	//the first time it is requested, and stays loaded until the process exits, so every solver shares one copy
+	//of its move tables and one mapping of its file. Tables at different paths are loaded independently, so
+	//threads requesting different tables don't wait for each other
+	class StageTableRegistry {
+		private:
+			//a table and the flag making sure it is only loaded once
+			struct Entry {
+				std::once_flag loaded;
+				std::shared_ptr<const StageTable> table;
+			};
+
+			std::mutex entries_mutex;
+			std::unordered_map<std::string, std::shared_ptr<Entry>> entries;
+
+			StageTableRegistry() = default;
+
+		public:
+			StageTableRegistry(const StageTableRegistry&) = delete;
+			StageTableRegistry& operator=(const StageTableRegistry&) = delete;
+
+			//returns the registry of the process
+			static StageTableRegistry& get_instance();
+
+			//returns the table stored at the given path. The first request for a path loads the table
+			//created by 'create_table', and every later request returns the same table without calling it
+			std::shared_ptr<const StageTable> get_table(const boost::filesystem::path& file_path,
+					const std::function<std::unique_ptr<StageTable>()>& create_table);
+	};
+}
+
+#endif
@@ -11,6 +11,10 @@ namespace ai {
 	class TwistListener {
 		public:
 			virtual void twist(const cube::Twist& twist) = 0;
+
+			//called when a search finds a shorter solution to the step being solved. The twists are only
+			//reported, and are made through 'twist' once the step is finished
+			virtual void solution_improved(const std::vector<cube::Twist>& twists) {}
 	};
 }
 
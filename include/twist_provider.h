@@ -19,6 +19,13 @@ namespace ai {
 					}	
 				}
 			}
+
+			//reports a shorter solution to the step being solved to the TwistListeners, without making its twists
+			void notify_improvement(const std::vector<cube::Twist>& twists) {
+				for (const auto listener_ptr : twist_listeners) {
+					listener_ptr -> solution_improved(twists);
+				}
+			}
 		public:
 			void add_twist_listener(TwistListener* listener) {
 				twist_listeners.push_back(listener);
@@ -22,6 +22,21 @@ namespace ai {
 		//generates a set of TwistSequences that represent 90 and -90
 		//degree rotations of the whole cube around every axis
 		std::vector<TwistSequence> generate_cube_rotations(const cube::CubeBase& cube);
+
+		//returns the TwistSequence that undoes the given one
+		TwistSequence invert(const TwistSequence& twist_seq);
+
+		//returns the position each center piece of a cube of the given size is moved to by the given twists
+		std::vector<int> trace_center_pieces(const int size, const TwistSequence& twist_seq);
+
+		//returns the position each wing of a cube of the given size is moved to by the given twists, and
+		//whether it is flipped
+		std::vector<std::pair<int, bool>> trace_wings(const int size, const TwistSequence& twist_seq);
+
+		//returns the orbits of the center pieces of a cube of the given size, the sets of 24 positions pieces 
+		//can be moved between, with the positions of each in increasing order. The fixed centers of odd cubes
+		//aren't in an orbit of 24 positions, and are left out
+		std::vector<std::vector<int>> find_center_orbits(const int size);
 	};
 }
 #endif
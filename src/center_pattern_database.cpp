@@ -0,0 +1,268 @@
+#include "center_pattern_database.h"
+#include "checkpoint.h"
+#include "twist_utils.h"
+#include "twist.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace ai;
+using namespace search;
+
+constexpr uint32_t CenterPatternDatabase::magic;
+constexpr uint32_t CenterPatternDatabase::version;
+
+namespace {
+	//binomials[n][k] is the number of ways to choose k of n items, for the n and k needed to rank placements
+	std::array<std::array<int, 5>, 24> make_binomials() {
+		std::array<std::array<int, 5>, 24> binomials = {};
+		for (int n = 0; n < binomials.size(); n++) {
+			binomials[n][0] = 1;
+			for (int k = 1; k < binomials[n].size(); k++) {
+				binomials[n][k] = n == 0 ? 0 : binomials[n-1][k-1] + binomials[n-1][k];
+			}
+		}
+
+		return binomials;
+	}
+
+	const std::array<std::array<int, 5>, 24> binomials = make_binomials();
+}
+
+std::vector<CenterPatternDatabase::Orbit> CenterPatternDatabase::find_orbits(const int size) {
+	std::vector<Orbit> orbits;
+	for (const auto& center_orbit : TwistUtils::find_center_orbits(size)) {
+		Orbit orbit;
+		std::copy(center_orbit.begin(), center_orbit.end(), orbit.begin());
+		orbits.push_back(orbit);
+	}
+
+	return orbits;
+}
+
+int CenterPatternDatabase::rank_placement(const std::array<uint8_t, colour_pieces>& placement) {
+	int rank = 0;
+	for (int i = 0; i < colour_pieces; i++) {
+		rank += binomials[placement[i]][i+1];
+	}
+
+	return rank;
+}
+
+std::vector<uint8_t> CenterPatternDatabase::generate_distances(const Orbit& orbit, const int pieces_in_center, const std::vector<PatternMove>& moves) {
+	//the placements in order of their rank
+	std::vector<std::array<uint8_t, colour_pieces>> placements;
+	placements.reserve(placement_count);
+	for (uint8_t d = 3; d < orbit_size; d++) {
+		for (uint8_t c = 2; c < d; c++) {
+			for (uint8_t b = 1; b < c; b++) {
+				for (uint8_t a = 0; a < b; a++) {
+					placements.push_back({a, b, c, d});
+				}
+			}
+		}
+	}
+
+	//the search runs backwards from the solved patterns, so each move is inverted
+	std::vector<PatternMove> inverse_moves(moves);
+	for (int i = 0; i < moves.size(); i++) {
+		for (int position = 0; position < orbit_size; position++) {
+			inverse_moves[i].positions[moves[i].positions[position]] = position;
+		}
+		for (int face = 0; face < face_count; face++) {
+			inverse_moves[i].faces[moves[i].faces[face]] = face;
+		}
+	}
+
+	//moves differ in cost, so the patterns are expanded in order of distance from a bucket for each distance.
+	//Distances are stored in a byte, and patterns that can't be reached in fewer than 255 twists are left at 255
+	const int unreached = 255;
+	std::vector<uint8_t> distances(pattern_count, unreached);
+	std::vector<std::vector<int>> buckets(unreached);
+	for (int face = 0; face < face_count; face++) {
+		std::array<uint8_t, colour_pieces> solved_placement;
+		int piece = 0;
+		for (int position = 0; position < orbit_size; position++) {
+			if (orbit[position]/pieces_in_center == face) {
+				solved_placement[piece++] = position;
+			}
+		}
+		int pattern = face*placement_count + rank_placement(solved_placement);
+		distances[pattern] = 0;
+		buckets[0].push_back(pattern);
+	}
+
+	for (int distance = 0; distance < unreached; distance++) {
+		for (const int pattern : buckets[distance]) {
+			if (distances[pattern] != distance) {
+				continue;
+			}
+			int face = pattern/placement_count;
+			const auto& placement = placements[pattern%placement_count];
+			for (const auto& move : inverse_moves) {
+				int previous_distance = distance + move.cost;
+				if (previous_distance >= unreached) {
+					continue;
+				}
+				std::array<uint8_t, colour_pieces> previous_placement;
+				for (int i = 0; i < colour_pieces; i++) {
+					previous_placement[i] = move.positions[placement[i]];
+				}
+				std::sort(previous_placement.begin(), previous_placement.end());
+				int previous_pattern = move.faces[face]*placement_count + rank_placement(previous_placement);
+				if (previous_distance < distances[previous_pattern]) {
+					distances[previous_pattern] = previous_distance;
+					buckets[previous_distance].push_back(previous_pattern);
+				}
+			}
+		}
+		std::vector<int>().swap(buckets[distance]);
+	}
+
+	return distances;
+}
+
+void CenterPatternDatabase::generate(const boost::filesystem::path& file_path, const int size, const std::vector<TwistSequence>& twist_sequences,
+		const std::size_t key) {
+	int pieces_in_center = cube::CubeCenters(size).get_pieces_in_center();
+	auto orbits = find_orbits(size);
+
+	//the faces each TwistSequence moves the pieces belonging on each face to, found from the faces
+	//the solved values are moved to
+	std::vector<std::vector<int>> destinations;
+	std::vector<std::array<uint8_t, face_count>> face_moves;
+	for (const auto& twist_seq : twist_sequences) {
+		destinations.push_back(TwistUtils::trace_center_pieces(size, twist_seq));
+		cube::CubeCenters centers(size);
+		for (const auto& twist : twist_seq) {
+			centers.rotate(twist);
+		}
+		std::array<uint8_t, face_count> faces;
+		for (const auto face : cube::ALL_FACES) {
+			faces[centers.get_solved_center_value(face)] = static_cast<int>(face);
+		}
+		face_moves.push_back(faces);
+	}
+
+	checkpoint::save(file_path, [&](std::ostream& file) {
+		checkpoint::write_value(file, magic);
+		checkpoint::write_value(file, version);
+		checkpoint::write_value<uint32_t>(file, size);
+		checkpoint::write_value<uint64_t>(file, key);
+		checkpoint::write_value<uint32_t>(file, orbits.size());
+		for (const auto& orbit : orbits) {
+			file.write(reinterpret_cast<const char*>(orbit.data()), sizeof(orbit));
+		}
+
+		for (const auto& orbit : orbits) {
+			std::vector<int> orbit_indices(pieces_in_center*face_count, -1);
+			for (int i = 0; i < orbit_size; i++) {
+				orbit_indices[orbit[i]] = i;
+			}
+			//TwistSequences that move the orbit the same way only need to be searched once, with the lowest cost
+			std::vector<PatternMove> moves;
+			for (int i = 0; i < twist_sequences.size(); i++) {
+				PatternMove move;
+				for (int position = 0; position < orbit_size; position++) {
+					move.positions[position] = orbit_indices[destinations[i][orbit[position]]];
+				}
+				move.faces = face_moves[i];
+				move.cost = twist_sequences[i].size();
+
+				auto same_move = std::find_if(moves.begin(), moves.end(), [&move](const PatternMove& other) {
+					return other.positions == move.positions && other.faces == move.faces;
+				});
+				if (same_move == moves.end()) {
+					moves.push_back(move);
+				}
+				else {
+					same_move->cost = std::min(same_move->cost, move.cost);
+				}
+			}
+
+			auto distances = generate_distances(orbit, pieces_in_center, moves);
+			file.write(reinterpret_cast<const char*>(distances.data()), distances.size());
+		}
+	});
+}
+
+CenterPatternDatabase::CenterPatternDatabase(const boost::filesystem::path& file_path, const int size, const std::vector<TwistSequence>& twist_sequences,
+		const PatternCombination combination) : combination(combination) {
+	std::size_t key = checkpoint::hash_twist_sequences(twist_sequences);
+
+	//returns true if the file starts with a header written for the given size and TwistSequences, and reads the orbits after it
+	auto read_header = [this, &file_path, size, key]() {
+		std::ifstream stream(file_path.string(), std::ifstream::binary);
+		try {
+			if (checkpoint::read_value<uint32_t>(stream) != magic || checkpoint::read_value<uint32_t>(stream) != version ||
+					checkpoint::read_value<uint32_t>(stream) != size || checkpoint::read_value<uint64_t>(stream) != key) {
+				return false;
+			}
+			orbits.resize(checkpoint::read_value<uint32_t>(stream));
+			for (auto& orbit : orbits) {
+				orbit = checkpoint::read_value<Orbit>(stream);
+			}
+		}
+		catch (const std::runtime_error&) {
+			return false;
+		}
+
+		return true;
+	};
+
+	{
+		//solvers racing in other threads or processes may load the same database, which is only generated once
+		checkpoint::FileLock lock(file_path);
+		if (!boost::filesystem::exists(file_path) || !read_header()) {
+			std::cout << "Generating the center pattern database " << file_path.string() << ". This may take some time.\n";
+			generate(file_path, size, twist_sequences, key);
+			if (!read_header()) {
+				throw std::runtime_error("Couldn't read pattern database " + file_path.string());
+			}
+			std::cout << "Center pattern database generated\n";
+		}
+	}
+
+	file.open(file_path.string());
+	std::size_t header_length = 3*sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint32_t) + orbits.size()*sizeof(Orbit);
+	if (file.size() != header_length + orbits.size()*pattern_count) {
+		throw std::runtime_error("Pattern database " + file_path.string() + " has the wrong size");
+	}
+	for (int i = 0; i < orbits.size(); i++) {
+		distances.push_back(reinterpret_cast<const uint8_t*>(file.data()) + header_length + i*pattern_count);
+	}
+}
+
+int CenterPatternDatabase::operator()(const cube::CubeCenters& centers, const int faces) const {
+	//the face the pieces of each colour belong on
+	std::array<int, face_count> colour_faces;
+	for (const auto face : cube::ALL_FACES) {
+		colour_faces[centers.get_solved_center_value(face)] = static_cast<int>(face);
+	}
+
+	int estimate = 0;
+	for (int i = 0; i < orbits.size(); i++) {
+		//the placements of each colour are ranked as they are found, since the positions are in increasing order
+		std::array<int, face_count> ranks = {};
+		std::array<int, face_count> found_pieces = {};
+		for (int position = 0; position < orbit_size; position++) {
+			int colour = centers.get_center_pos(orbits[i][position]);
+			ranks[colour] += binomials[position][++found_pieces[colour]];
+		}
+		for (int colour = 0; colour < face_count; colour++) {
+			if (!(faces >> colour_faces[colour] & 1)) {
+				continue;
+			}
+			int distance = distances[i][colour_faces[colour]*placement_count + ranks[colour]];
+			if (combination == PatternCombination::SUM) {
+				estimate += distance;
+			}
+			else {
+				estimate = std::max(estimate, distance);
+			}
+		}
+	}
+
+	return estimate;
+}
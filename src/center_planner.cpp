@@ -0,0 +1,219 @@
+#include "center_planner.h"
+#include "twist_utils.h"
+#include "twist.h"
+#include "face.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace ai;
+
+namespace {
+	int encode_cycle(const int a, const int b, const int c) {
+		return (a*24 + b)*24 + c;
+	}
+}
+
+std::vector<std::pair<std::vector<int>, TwistSequence>> CenterPlanner::find_orbit_commutators(const int size, 
+		const std::vector<TwistSequence>& commutators) {
+	int piece_count = cube::CubeCenters(size).get_pieces_in_center()*cube::ALL_FACES.size();
+
+	std::vector<std::pair<std::vector<int>, TwistSequence>> orbit_commutators;
+	std::vector<int> piece_orbits(piece_count, -1);
+	for (const auto& orbit : TwistUtils::find_center_orbits(size)) {
+		for (const int piece : orbit) {
+			piece_orbits[piece] = orbit_commutators.size();
+		}
+		orbit_commutators.emplace_back(orbit, TwistSequence());
+	}
+
+	//each completed commutator is kept for the orbit it cycles, if it moves no other piece
+	for (const auto& commutator : commutators) {
+		TwistSequence completed(commutator);
+		completed.push_back(cube::Twist(90, cube::Face::TOP));
+		auto destinations = TwistUtils::trace_center_pieces(size, completed);
+		std::vector<int> moved_pieces;
+		for (int piece = 0; piece < piece_count; piece++) {
+			if (destinations[piece] != piece) {
+				moved_pieces.push_back(piece);
+			}
+		}
+		if (moved_pieces.size() == 3 && piece_orbits[moved_pieces[0]] != -1 && orbit_commutators[piece_orbits[moved_pieces[0]]].second.empty()) {
+			orbit_commutators[piece_orbits[moved_pieces[0]]].second = completed;
+		}
+	}
+
+	return orbit_commutators;
+}
+
+CenterPlanner::CenterPlanner(const int size, const std::vector<TwistSequence>& commutators) : size(size) {
+	int piece_count = cube::CubeCenters(size).get_pieces_in_center()*cube::ALL_FACES.size();
+
+	//the index in its orbit of each piece
+	std::vector<int> piece_indices(piece_count);
+	for (const auto& orbit_commutator : find_orbit_commutators(size, commutators)) {
+		OrbitLibrary library;
+		library.positions = orbit_commutator.first;
+		library.commutator = orbit_commutator.second;
+		if (library.commutator.empty()) {
+			throw std::invalid_argument("No commutator cycles the center orbit containing piece " + std::to_string(library.positions.front()));
+		}
+		for (int i = 0; i < orbit_size; i++) {
+			piece_indices[library.positions[i]] = i;
+		}
+		libraries.push_back(library);
+	}
+	for (auto& library : libraries) {
+		auto destinations = TwistUtils::trace_center_pieces(size, library.commutator);
+		int a = library.positions.front();
+		while (destinations[a] == a) {
+			a = library.positions[piece_indices[a] + 1];
+		}
+		int b = destinations[a];
+		int c = destinations[b];
+		library.commutator_cycle = encode_cycle(piece_indices[a], piece_indices[b], piece_indices[c]);
+	}
+
+	//the setup twists of an orbit are the slice rotations that move its pieces
+	for (const auto axis : TwistUtils::AXIS_FACES) {
+		for (int layer = 0; layer < size; layer++) {
+			for (const int degrees : TwistUtils::DEGREES) {
+				cube::Twist twist(degrees, axis, layer, false);
+				auto destinations = TwistUtils::trace_center_pieces(size, {twist});
+				for (auto& library : libraries) {
+					std::array<uint8_t, orbit_size> orbit_destinations;
+					bool moves_orbit = false;
+					for (int i = 0; i < orbit_size; i++) {
+						orbit_destinations[i] = piece_indices[destinations[library.positions[i]]];
+						moves_orbit = moves_orbit || orbit_destinations[i] != i;
+					}
+					if (moves_orbit) {
+						library.setup_twists.push_back(twist);
+						library.setup_destinations.push_back(orbit_destinations);
+					}
+				}
+			}
+		}
+	}
+
+	for (auto& library : libraries) {
+		build_library(library);
+	}
+}
+
+void CenterPlanner::build_library(OrbitLibrary& library) {
+	//the index each setup twist moves the piece at each index from
+	std::vector<std::array<uint8_t, orbit_size>> setup_sources(library.setup_destinations.size());
+	for (int twist = 0; twist < setup_sources.size(); twist++) {
+		for (int i = 0; i < orbit_size; i++) {
+			setup_sources[twist][library.setup_destinations[twist][i]] = i;
+		}
+	}
+
+	//a setup twist followed by the setup of a cycle, the commutator and the inverse of both makes
+	//the cycle of the indices the twist moves to the cycle's indices
+	library.first_setup_twist.assign(cycle_count, -2);
+	library.first_setup_twist[library.commutator_cycle] = -1;
+	std::vector<int> queue = {library.commutator_cycle};
+	for (int head = 0; head < queue.size(); head++) {
+		int cycle = queue[head];
+		int a = cycle/(orbit_size*orbit_size);
+		int b = cycle/orbit_size%orbit_size;
+		int c = cycle%orbit_size;
+		for (int twist = 0; twist < setup_sources.size(); twist++) {
+			const auto& sources = setup_sources[twist];
+			int previous_cycle = encode_cycle(sources[a], sources[b], sources[c]);
+			if (library.first_setup_twist[previous_cycle] == -2) {
+				library.first_setup_twist[previous_cycle] = twist;
+				queue.push_back(previous_cycle);
+			}
+		}
+	}
+}
+
+TwistSequence CenterPlanner::make_cycle(const OrbitLibrary& library, const int cycle) const {
+	if (library.first_setup_twist[cycle] == -2) {
+		throw std::invalid_argument("The center orbit has no setup for the given cycle");
+	}
+	TwistSequence setup;
+	for (int curr_cycle = cycle; library.first_setup_twist[curr_cycle] != -1; ) {
+		int twist = library.first_setup_twist[curr_cycle];
+		setup.push_back(library.setup_twists[twist]);
+		const auto& destinations = library.setup_destinations[twist];
+		curr_cycle = encode_cycle(destinations[curr_cycle/(orbit_size*orbit_size)], destinations[curr_cycle/orbit_size%orbit_size],
+				destinations[curr_cycle%orbit_size]);
+	}
+
+	TwistSequence twists(setup);
+	twists.insert(twists.end(), library.commutator.begin(), library.commutator.end());
+	auto undo_setup = TwistUtils::invert(setup);
+	twists.insert(twists.end(), undo_setup.begin(), undo_setup.end());
+
+	return twists;
+}
+
+search::SearchResult CenterPlanner::solve(const cube::CubeCenters& centers, const search::SearchLimits& limits) const {
+	if (centers.get_size() != size) {
+		throw std::invalid_argument("The centers must be the size the planner was built for");
+	}
+
+	//the 3-cycles leave the rest of the cube, and with it the solved value of each face, unchanged,
+	//so the pieces are cycled without rotating the centers
+	std::array<int, 6> solved_values;
+	for (const auto face : cube::ALL_FACES) {
+		solved_values[static_cast<int>(face)] = centers.get_solved_center_value(face);
+	}
+	std::vector<cube::Twist> twists;
+	for (const auto& library : libraries) {
+		std::array<int, orbit_size> pieces;
+		std::array<int, orbit_size> solved_pieces;
+		for (int i = 0; i < orbit_size; i++) {
+			pieces[i] = centers.get_center_pos(library.positions[i]);
+			solved_pieces[i] = solved_values[library.positions[i]/centers.get_pieces_in_center()];
+		}
+		auto is_solved = [&pieces, &solved_pieces](const int i) {
+			return pieces[i] == solved_pieces[i];
+		};
+
+		while (true) {
+			//the first unsolved piece is replaced with a piece that belongs in its position
+			int p = 0;
+			while (p < orbit_size && is_solved(p)) {
+				p++;
+			}
+			if (p == orbit_size) {
+				break;
+			}
+			int q = 0;
+			while (pieces[q] != solved_pieces[p] || is_solved(q)) {
+				q++;
+			}
+
+			//the third piece of the cycle is taken from p, and its own piece is moved to q. It must not be
+			//solved unless it gets an identical piece from p. Pieces solved by the moves are preferred
+			int r = -1;
+			int best_score = -1;
+			for (int i = 0; i < orbit_size; i++) {
+				if (i == p || i == q || (is_solved(i) && pieces[i] != pieces[p])) {
+					continue;
+				}
+				int score = (solved_pieces[i] == pieces[p]) + (pieces[i] == solved_pieces[q]);
+				if (score > best_score) {
+					r = i;
+					best_score = score;
+				}
+			}
+
+			if (auto status = limits.check()) {
+				return search::SearchResult(*status, twists);
+			}
+			auto cycle = make_cycle(library, encode_cycle(q, p, r));
+			twists.insert(twists.end(), cycle.begin(), cycle.end());
+			int r_piece = pieces[r];
+			pieces[r] = pieces[p];
+			pieces[p] = pieces[q];
+			pieces[q] = r_piece;
+		}
+	}
+
+	return search::SearchResult(search::SearchStatus::SOLVED, twists);
+}
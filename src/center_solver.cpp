@@ -7,26 +7,99 @@
 #include <queue>
 #include <limits>
 #include <iostream>
+#include <map>
+#include <algorithm>
+#include <thread>
 
 using namespace ai;
 
 int CenterSolver::CenterHeuristic::operator()(const cube::CubeCenters& centers) {
-	int heuristic_value = 0;
+	//every piece on the face opposite the one it belongs to adds 2, and every other unsolved piece adds 1
+	int total_center_pieces = centers.get_pieces_in_center()*6;
+	return total_center_pieces - centers.get_solved_piece_count() + centers.get_opposed_piece_count();
+}
+
+thread_local const CenterPatternDatabase* CenterSolver::active_pattern_database = nullptr;
+
+int CenterSolver::PatternDatabaseHeuristic::operator()(const cube::CubeCenters& centers) {
+	return (*active_pattern_database)(centers);
+}
+
+thread_local int CenterSolver::active_stage_faces = 0;
+
+int CenterSolver::StageHeuristic::operator()(const cube::CubeCenters& centers) {
+	if (active_pattern_database != nullptr) {
+		return (*active_pattern_database)(centers, active_stage_faces);
+	}
+	return count_unsolved_pieces(centers, active_stage_faces);
+}
+
+int CenterSolver::count_unsolved_pieces(const cube::CubeCenters& centers, const int faces) {
+	int unsolved_pieces = 0;
 	for (const auto face : cube::ALL_FACES) {
-		int face_start_index = static_cast<int>(face)*centers.get_pieces_in_center();
-		int solved_center_value = centers.get_solved_center_value(face);
-		for (int piece = 0; piece < centers.get_pieces_in_center(); piece++) {
-			int piece_value = centers.get_center_pos(face_start_index + piece);
-			if (piece_value == centers.get_solved_center_value(cube::OPPOSING_FACES.at(face))) {
-				heuristic_value += 2;
+		int face_index = static_cast<int>(face);
+		if (faces >> face_index & 1) {
+			int solved_value = centers.get_solved_center_value(face);
+			for (int i = face_index*centers.get_pieces_in_center(); i < (face_index+1)*centers.get_pieces_in_center(); i++) {
+				unsolved_pieces += centers.get_center_pos(i) != solved_value;
 			}
-			else if (piece_value != solved_center_value) {
-				heuristic_value++;
+		}
+	}
+
+	return unsolved_pieces;
+}
+
+int CenterSolver::OrbitHeuristic::operator()(const cube::OrbitCenters& orbit) {
+	return orbit.get_unsolved_piece_count() + orbit.get_opposed_piece_count();
+}
+
+std::vector<cube::OrbitCenters> CenterSolver::split_orbits(const cube::CubeCenters& centers, const std::vector<std::vector<int>>& orbit_positions) {
+	using namespace cube;
+	int size = centers.get_size();
+	int pieces_in_center = centers.get_pieces_in_center();
+
+	//the index of each piece in its orbit
+	std::vector<int> piece_indices(pieces_in_center*ALL_FACES.size(), -1);
+	std::vector<std::shared_ptr<OrbitCenters::OrbitTable>> tables;
+	for (const auto& positions : orbit_positions) {
+		auto table = std::make_shared<OrbitCenters::OrbitTable>();
+		table->size = size;
+		table->twist_destinations.resize(ALL_FACES.size()*size*2);
+		for (int i = 0; i < OrbitCenters::orbit_size; i++) {
+			piece_indices[positions[i]] = i;
+			Face face = static_cast<Face>(positions[i]/pieces_in_center);
+			table->solved_values[i] = centers.get_solved_center_value(face);
+			table->opposed_values[i] = centers.get_solved_center_value(OPPOSING_FACES.at(face));
+		}
+		tables.push_back(table);
+	}
+
+	//every single layer twist is traced once for all of the orbits
+	for (const auto face : ALL_FACES) {
+		for (int layer = 0; layer < size; layer++) {
+			for (const int degrees : TwistUtils::DEGREES) {
+				auto destinations = TwistUtils::trace_center_pieces(size, {Twist(degrees, face, layer, false)});
+				int twist_index = (static_cast<int>(face)*size + layer)*2 + (degrees == 90);
+				for (int orbit = 0; orbit < tables.size(); orbit++) {
+					auto& orbit_destinations = tables[orbit]->twist_destinations[twist_index];
+					for (int i = 0; i < OrbitCenters::orbit_size; i++) {
+						orbit_destinations[i] = piece_indices[destinations[orbit_positions[orbit][i]]];
+					}
+				}
 			}
-		}	
+		}
 	}
-	
-	return heuristic_value;
+
+	std::vector<OrbitCenters> orbits;
+	for (int orbit = 0; orbit < tables.size(); orbit++) {
+		std::array<uint8_t, OrbitCenters::orbit_size> pieces;
+		for (int i = 0; i < OrbitCenters::orbit_size; i++) {
+			pieces[i] = centers.get_center_pos(orbit_positions[orbit][i]);
+		}
+		orbits.emplace_back(tables[orbit], pieces);
+	}
+
+	return orbits;
 }
 
 std::vector<TwistSequence> CenterSolver::generate_commutators(const cube::CubeCenters& centers) {
@@ -89,40 +162,291 @@ std::vector<TwistSequence> CenterSolver::generate_strategy_2(const cube::CubeCen
 	return strategy;
 }
 
+std::vector<TwistSequence> CenterSolver::generate_stage_moves(const cube::CubeCenters& centers, const int solved_faces) {
+	using namespace cube;
+	int size = centers.get_size();
+
+	//the whole cube rotations that reach each of the 24 orientations of the cube
+	std::vector<TwistSequence> orientations = {TwistSequence()};
+	std::map<std::vector<int>, int> seen_orientations = {{TwistUtils::trace_center_pieces(size, {}), 0}};
+	for (int i = 0; i < orientations.size(); i++) {
+		for (const auto& rotation : TwistUtils::generate_cube_rotations(centers)) {
+			TwistSequence orientation(orientations[i]);
+			orientation.insert(orientation.end(), rotation.begin(), rotation.end());
+			if (seen_orientations.emplace(TwistUtils::trace_center_pieces(size, orientation), orientations.size()).second) {
+				orientations.push_back(orientation);
+			}
+		}
+	}
+
+	std::vector<TwistSequence> candidates = generate_strategy_1(centers);
+	auto face_twists = TwistUtils::generate_face_twists();
+	candidates.insert(candidates.end(), face_twists.begin(), face_twists.end());
+	for (const auto& commutator : generate_commutators(centers)) {
+		for (const auto& orientation : orientations) {
+			TwistSequence conjugate(orientation);
+			conjugate.insert(conjugate.end(), commutator.begin(), commutator.end());
+			auto undo_orientation = TwistUtils::invert(orientation);
+			conjugate.insert(conjugate.end(), undo_orientation.begin(), undo_orientation.end());
+			candidates.push_back(conjugate);
+		}
+	}
+
+	//candidates that move the pieces the same way are only kept once, and candidates that move
+	//a piece of a solved face off its face are left out
+	std::vector<TwistSequence> moves;
+	std::map<std::vector<int>, int> seen_moves = {{TwistUtils::trace_center_pieces(size, {}), -1}};
+	for (const auto& candidate : candidates) {
+		auto destinations = TwistUtils::trace_center_pieces(size, candidate);
+		bool keeps_solved_faces = true;
+		for (int piece = 0; piece < destinations.size() && keeps_solved_faces; piece++) {
+			int face = piece/centers.get_pieces_in_center();
+			keeps_solved_faces = !(solved_faces >> face & 1) || destinations[piece]/centers.get_pieces_in_center() == face;
+		}
+		if (keeps_solved_faces && seen_moves.emplace(destinations, moves.size()).second) {
+			moves.push_back(candidate);
+		}
+	}
+
+	return moves;
+}
+
 int CenterSolver::count_solved_pieces(const cube::CubeCenters& centers) {
-	int placed_pieces = 0;
-	for (const auto face : cube::ALL_FACES) {
-		for (int i = 0; i < centers.get_pieces_in_center(); i++) {
-			int piece_index = static_cast<int>(face)*centers.get_pieces_in_center() + i;
-			if (centers.get_center_pos(piece_index) == centers.get_solved_center_value(face)) {
-				placed_pieces++;
+	return centers.get_solved_piece_count();
+}
+
+CenterSolver::ProgressMonitor::ProgressMonitor(const int measurement_window, const int patience, const std::chrono::milliseconds stall_time, 
+		const int solved_pieces) :
+	measurement_window(measurement_window), 
+	patience(patience), 
+	initial_solved_pieces(solved_pieces),
+	best_solved_pieces(solved_pieces), 
+	window_start_solved_pieces(solved_pieces),
+	stall_time(stall_time),
+	start_time(std::chrono::steady_clock::now()),
+	last_gain_time(start_time) {}
+
+bool CenterSolver::ProgressMonitor::record(const int solved_pieces) {
+	best_solved_pieces = std::max(best_solved_pieces, solved_pieces);
+	if (++generated_states % measurement_window == 0) {
+		//the clock is only read once per window, so the time criterion is as coarse as the windows
+		auto now = std::chrono::steady_clock::now();
+		if (best_solved_pieces > window_start_solved_pieces) {
+			stalled_windows = 0;
+			last_gain_time = now;
+		}
+		else {
+			stalled_windows++;
+		}
+		window_start_solved_pieces = best_solved_pieces;
+		stalled = stalled_windows >= patience || (stall_time.count() > 0 && now - last_gain_time >= stall_time);
+	}
+
+	return stalled;
+}
+
+void CenterSolver::ProgressMonitor::log_progress(const int phase, const std::string& strategy_name) const {
+	auto elapsed_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time);
+	int gained_pieces = best_solved_pieces - initial_solved_pieces;
+	std::cout << "Phase " << phase << " (" << strategy_name << ") solved " << gained_pieces << " pieces in " 
+		<< generated_states << " states and " << elapsed_time.count() << " ms (" 
+		<< 1000.0*gained_pieces/std::max(generated_states, 1) << " pieces per thousand states)";
+	if (stalled) {
+		auto stalled_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - last_gain_time);
+		std::cout << ", stalled after " << stalled_windows << " measurements and " << stalled_time.count() << " ms without a newly solved piece";
+	}
+	std::cout << "\n";
+}
+
+void CenterSolver::load_pattern_databases(const cube::CubeCenters& centers) {
+	if (!settings.use_pattern_databases || strategy_1_database != nullptr) {
+		return;
+	}
+	std::string size = std::to_string(centers.get_size());
+	strategy_1_database = std::make_unique<CenterPatternDatabase>(settings.pattern_database_dir/("centers_" + size + "_strategy_1.pdb"), 
+			centers.get_size(), generate_strategy_1(centers), settings.pattern_combination);
+	strategy_2_database = std::make_unique<CenterPatternDatabase>(settings.pattern_database_dir/("centers_" + size + "_strategy_2.pdb"), 
+			centers.get_size(), generate_strategy_2(centers), settings.pattern_combination);
+}
+
+template<typename Heuristic>
+search::SearchResult CenterSolver::run_search(const cube::CubeCenters& state, const bool use_strategy_1, 
+		const std::function<bool(const cube::CubeCenters&)>& is_finished, const search::SearchLimits& phase_limits) {
+	if (use_strategy_1) {
+		return search::best_first_search<cube::CubeCenters, Heuristic>(state, generate_strategy_1(state), is_finished, phase_limits);
+	}
+	auto log_improvement = [this](const std::vector<cube::Twist>& twists) {
+		std::cout << "Found a center solution of " << twists.size() << " twists\n";
+		notify_improvement(twists);
+	};
+	//most of the children of each state in this search are never expanded, so by default they 
+	//are only stored once they are needed
+	return search::anytime_weighted_a_star_search<cube::CubeCenters, Heuristic>(
+				state, generate_strategy_2(state), is_finished, settings.refinement_budget, phase_limits, 
+				log_improvement, settings.partial_expansion);
+}
+
+search::SearchResult CenterSolver::run_phase(const cube::CubeCenters& state, const int phase, const bool use_strategy_1, const bool monitored) {
+	int total_center_pieces = state.get_pieces_in_center()*6;
+	int patience = use_strategy_1 ? settings.strategy_1_patience : settings.strategy_2_patience;
+	ProgressMonitor monitor(settings.measurement_window, patience, settings.stall_time, count_solved_pieces(state));
+
+	//a monitored phase is stopped through its own cancellation token, which also forwards the 
+	//caller's token. Phases that end early would leave checkpoints no later run resumes, 
+	//so only the last phase is checkpointed
+	search::CancellationToken phase_cancellation(false);
+	search::SearchLimits phase_limits(limits);
+	if (monitored) {
+		phase_limits.cancellation_token = &phase_cancellation;
+		phase_limits.checkpoint = boost::none;
+	}
+	auto is_finished = [this, &monitor, &phase_cancellation, monitored, total_center_pieces](const cube::CubeCenters& centers) {
+		int solved_pieces = this->count_solved_pieces(centers);
+		bool stalled = monitor.record(solved_pieces);
+		if (monitored) {
+			bool caller_cancelled = limits.cancellation_token != nullptr && limits.cancellation_token->load(std::memory_order_relaxed);
+			if (stalled || caller_cancelled) {
+				phase_cancellation = true;
 			}
-		}	
+		}
+		return solved_pieces == total_center_pieces;
+	};
+
+	search::SearchResult result(search::SearchStatus::SOLVED, std::vector<cube::Twist>());
+	if (settings.use_pattern_databases) {
+		active_pattern_database = use_strategy_1 ? strategy_1_database.get() : strategy_2_database.get();
+		result = run_search<PatternDatabaseHeuristic>(state, use_strategy_1, is_finished, phase_limits);
+		active_pattern_database = nullptr;
 	}
+	else {
+		result = run_search<CenterHeuristic>(state, use_strategy_1, is_finished, phase_limits);
+	}
+	monitor.log_progress(phase, use_strategy_1 ? "strategy 1" : "commutator based search");
 
-	return placed_pieces;
+	return result;
 }
 
-void CenterSolver::solve(const cube::CubeCenters& root_state) {
+search::SearchStatus CenterSolver::solve_staged(const cube::CubeCenters& root_state) {
+	using namespace cube;
 	cube::CubeCenters curr_state(root_state);
-	int states_searched = 0;
-	int strategy_change_threshold = curr_state.get_size()*2500;
-	int total_center_pieces = curr_state.get_pieces_in_center()*6;
-	auto strategy_1_finished = [strategy_change_threshold, states_searched=0, total_center_pieces, this] (const cube::CubeCenters& centers) mutable {
-		states_searched++;
-		return states_searched == strategy_change_threshold || this->count_solved_pieces(centers) == total_center_pieces;
+
+	Face first_face = *std::max_element(ALL_FACES.begin(), ALL_FACES.end(), [&curr_state](const Face face1, const Face face2) {
+		return count_unsolved_pieces(curr_state, 1 << static_cast<int>(face1)) > count_unsolved_pieces(curr_state, 1 << static_cast<int>(face2));
+	});
+	Face second_face = OPPOSING_FACES.at(first_face);
+	int first_faces = 1 << static_cast<int>(first_face);
+	int second_faces = first_faces | 1 << static_cast<int>(second_face);
+	int all_faces = (1 << ALL_FACES.size()) - 1;
+
+	//each stage solves the faces of its mask, keeping the faces of the previous stage solved
+	std::array<std::pair<int, int>, 3> stages = {{{0, first_faces}, {first_faces, second_faces}, {second_faces, all_faces}}};
+	for (int stage = 0; stage < stages.size(); stage++) {
+		std::cout << "Beginning center stage " << stage+1 << "\n";
+		int stage_faces = stages[stage].second;
+		auto is_finished = [stage_faces](const cube::CubeCenters& centers) {
+			return count_unsolved_pieces(centers, stage_faces) == 0;
+		};
+		auto moves = generate_stage_moves(curr_state, stages[stage].first);
+
+		//the first stage may use any move, so the database of the commutator based search guides it. The
+		//databases don't know the moves left to the later stages, which count the unsolved pieces instead
+		active_stage_faces = stage_faces;
+		active_pattern_database = stage == 0 ? strategy_2_database.get() : nullptr;
+		auto result = search::best_first_search<cube::CubeCenters, StageHeuristic>(curr_state, moves, is_finished, limits, settings.partial_expansion);
+		active_stage_faces = 0;
+		active_pattern_database = nullptr;
+		notify_listeners(result.twists);
+		if (!result.solved()) {
+			std::cout << "Center search stopped: " << result.status << "\n";
+			return result.status;
+		}
+		for (const auto& twist : result.twists) {
+			curr_state.rotate(twist);
+		}
+	}
+
+	std::cout << "Finished solving centers\n";
+	return search::SearchStatus::SOLVED;
+}
+
+search::SearchStatus CenterSolver::solve_orbits(const cube::CubeCenters& root_state) {
+	auto orbit_commutators = CenterPlanner::find_orbit_commutators(root_state.get_size(), generate_commutators(root_state));
+	std::vector<std::vector<int>> orbit_positions;
+	for (const auto& orbit_commutator : orbit_commutators) {
+		if (orbit_commutator.second.empty()) {
+			throw std::invalid_argument("No commutator cycles the center orbit containing piece " + std::to_string(orbit_commutator.first.front()));
+		}
+		orbit_positions.push_back(orbit_commutator.first);
+	}
+	auto orbits = split_orbits(root_state, orbit_positions);
+
+	auto generate_moves = [&](const int orbit) {
+		auto commutator = orbit_commutators[orbit].second;
+		return search::generate_orbit_moves(orbits[orbit], {commutator, TwistUtils::invert(commutator)}, settings.orbit_setup_depth);
 	};
-	std::cout << "Beginning solving the centers using strategy 1\n";
-	auto strategy_1_twists = search::best_first_search<cube::CubeCenters, CenterHeuristic>(curr_state, generate_strategy_1(curr_state), strategy_1_finished);
-	notify_listeners(strategy_1_twists);
-	for (const auto& twist : strategy_1_twists) {
-		curr_state.rotate(twist);	
-	}
-	std::cout << "Strategy 1 finished. Beginning commutator based search\n";
-	auto strategy_2_finished = [this, total_center_pieces](const cube::CubeCenters& centers) {
-		return this->count_solved_pieces(centers) == total_center_pieces;
+	auto is_finished = [](const cube::OrbitCenters& orbit) {
+		return orbit.get_unsolved_piece_count() == 0;
 	};
-	notify_listeners(search::best_first_search<cube::CubeCenters, CenterHeuristic>(curr_state, generate_strategy_2(curr_state), strategy_2_finished));
+	int threads = settings.orbit_threads > 0 ? settings.orbit_threads : std::thread::hardware_concurrency();
+	int worker_count = std::max(1, std::min<int>(threads, orbits.size()));
+	std::cout << "Solving " << orbits.size() << " center orbits on " << worker_count << " threads\n";
+	auto result = search::orbit_search<cube::OrbitCenters, OrbitHeuristic>(orbits, generate_moves, is_finished, worker_count, limits,
+			settings.partial_expansion);
+	notify_listeners(result.twists);
+	if (!result.solved()) {
+		std::cout << "Center search stopped: " << result.status << "\n";
+		return result.status;
+	}
+
+	std::cout << "Finished solving centers\n";
+	return search::SearchStatus::SOLVED;
+}
+
+search::SearchStatus CenterSolver::solve(const cube::CubeCenters& root_state) {
+	if (settings.constructive) {
+		std::cout << "Solving centers with 3-cycles\n";
+		CenterPlanner planner(root_state.get_size(), generate_commutators(root_state));
+		auto result = planner.solve(root_state, limits);
+		notify_listeners(result.twists);
+		if (!result.solved()) {
+			std::cout << "Center planning stopped: " << result.status << "\n";
+			return result.status;
+		}
+		std::cout << "Finished solving centers\n";
+		return search::SearchStatus::SOLVED;
+	}
+	if (settings.orbit_parallel) {
+		return solve_orbits(root_state);
+	}
+	load_pattern_databases(root_state);
+	if (settings.staged) {
+		return solve_staged(root_state);
+	}
+	cube::CubeCenters curr_state(root_state);
+	bool use_strategy_1 = settings.begin_with_strategy_1;
+	for (int phase = 1; ; phase++) {
+		//the last phase always runs the commutator based search, so the solve ends
+		bool last_phase = phase >= settings.max_phases;
+		if (last_phase) {
+			use_strategy_1 = false;
+		}
+		std::cout << "Beginning center phase " << phase << " using " << (use_strategy_1 ? "strategy 1" : "the commutator based search") << "\n";
+		auto result = run_phase(curr_state, phase, use_strategy_1, !last_phase);
+		notify_listeners(result.twists);
+		if (result.solved()) {
+			break;
+		}
+		if (result.status != search::SearchStatus::CANCELLED || limits.check()) {
+			std::cout << "Center search stopped: " << result.status << "\n";
+			return result.status;
+		}
+		for (const auto& twist : result.twists) {
+			curr_state.rotate(twist);	
+		}
+		std::cout << "Phase " << phase << " stalled. Switching to " << (use_strategy_1 ? "the commutator based search" : "strategy 1") << "\n";
+		use_strategy_1 = !use_strategy_1;
+	}
 
 	std::cout << "Finished solving centers\n";
+	return search::SearchStatus::SOLVED;
 }
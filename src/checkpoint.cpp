@@ -0,0 +1,119 @@
+#include "checkpoint.h"
+#include "hash.h"
+#include <boost/functional/hash.hpp>
+#include <boost/interprocess/exceptions.hpp>
+#include <map>
+#include <thread>
+#include <cerrno>
+
+using namespace ai;
+using namespace search;
+
+void checkpoint::write_twists(std::ostream& stream, const std::vector<cube::Twist>& twists) {
+	write_value<uint32_t>(stream, twists.size());
+	for (const auto& twist : twists) {
+		write_value<int8_t>(stream, twist.degrees/90);
+		write_value<uint8_t>(stream, static_cast<uint8_t>(twist.face));
+		write_value<uint8_t>(stream, twist.layer);
+		write_value<uint8_t>(stream, twist.wide_turn);
+	}
+}
+
+std::vector<cube::Twist> checkpoint::read_twists(std::istream& stream) {
+	std::vector<cube::Twist> twists;
+	uint32_t twist_count = read_value<uint32_t>(stream);
+	for (uint32_t i = 0; i < twist_count; i++) {
+		int degrees = read_value<int8_t>(stream)*90;
+		auto face = static_cast<cube::Face>(read_value<uint8_t>(stream));
+		int layer = read_value<uint8_t>(stream);
+		bool wide_turn = read_value<uint8_t>(stream);
+		twists.push_back(cube::Twist(degrees, face, layer, wide_turn));
+	}
+
+	return twists;
+}
+
+void checkpoint::write_header(std::ostream& stream, const std::size_t key) {
+	write_value(stream, magic);
+	write_value(stream, version);
+	write_value<uint64_t>(stream, key);
+}
+
+bool checkpoint::read_header(std::istream& stream, const std::size_t key) {
+	return read_value<uint32_t>(stream) == magic 
+		&& read_value<uint32_t>(stream) == version 
+		&& read_value<uint64_t>(stream) == key;
+}
+
+std::size_t checkpoint::hash_twist_sequences(const std::vector<TwistSequence>& twist_sequences) {
+	std::size_t seed = 0;
+	for (const auto& twist_seq : twist_sequences) {
+		boost::hash_combine(seed, twist_seq.size());
+		for (const auto& twist : twist_seq) {
+			boost::hash_combine(seed, std::hash<cube::Twist>()(twist));
+		}
+	}
+
+	return seed;
+}
+
+void checkpoint::save(const boost::filesystem::path& file_path, const std::function<void(std::ostream&)>& writer) {
+	if (file_path.has_parent_path() && !boost::filesystem::exists(file_path.parent_path())) {
+		boost::filesystem::create_directories(file_path.parent_path());
+	}
+	auto temp_path = file_path;
+	temp_path += ".tmp";
+	{
+		std::ofstream file(temp_path.string(), std::ofstream::binary);
+		writer(file);
+		if (!file) {
+			throw std::runtime_error("Couldn't write checkpoint " + temp_path.string());
+		}
+	}
+	boost::filesystem::rename(temp_path, file_path);
+}
+
+void checkpoint::remove(const boost::filesystem::path& file_path) {
+	boost::system::error_code error;
+	boost::filesystem::remove(file_path, error);
+}
+
+checkpoint::FileLock::FileLock(const boost::filesystem::path& file_path) {
+	//one mutex for each file, so threads locking different files don't wait for each other
+	static std::mutex mutexes_mutex;
+	static std::map<std::string, std::mutex> mutexes;
+	auto lock_path = file_path;
+	lock_path += ".lock";
+	std::mutex* mutex;
+	{
+		std::lock_guard<std::mutex> lock(mutexes_mutex);
+		mutex = &mutexes[lock_path.string()];
+	}
+	thread_lock = std::unique_lock<std::mutex>(*mutex);
+
+	if (file_path.has_parent_path() && !boost::filesystem::exists(file_path.parent_path())) {
+		boost::filesystem::create_directories(file_path.parent_path());
+	}
+	std::ofstream(lock_path.string(), std::ofstream::app);
+	process_lock = std::make_unique<boost::interprocess::file_lock>(lock_path.string().c_str());
+
+	//file locks are held by processes rather than threads, so two processes whose threads lock the same files in
+	//different orders look like a deadlock to the system, and the lock fails. The other thread will finish, so
+	//locking is tried again
+	while (true) {
+		try {
+			process_lock->lock();
+			break;
+		}
+		catch (const boost::interprocess::interprocess_exception& exception) {
+			if (exception.get_native_error() != EDEADLK) {
+				throw;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+}
+
+checkpoint::FileLock::~FileLock() {
+	process_lock->unlock();
+}
@@ -10,7 +10,8 @@ using namespace cube;
 Cube::Cube(const int size) : 
 	CubeBase(size),
 	edges(std::make_unique<uint8_t[]>(edge_width*edge_count)),
-	corners(std::make_unique<uint8_t[]>(corner_count)) {
+	corners(std::make_unique<uint8_t[]>(corner_count)),
+	paired_edges((1 << edge_count) - 1) {
 
 	for (int i = 0; i < edge_width*edge_count; i++) {
 		edges[i] = i/edge_width;
@@ -23,13 +24,15 @@ Cube::Cube(const int size) :
 Cube::Cube(const Cube& cube) : 
 	CubeBase(cube),
 	edges(copy_pieces(cube.edges.get(), edge_width*edge_count)), 
-	corners(copy_pieces(cube.corners.get(), corner_count)) {}
+	corners(copy_pieces(cube.corners.get(), corner_count)),
+	paired_edges(cube.paired_edges) {}
 
 Cube& Cube::operator=(const Cube& cube) {
 	assert(cube.size == size && "Cube classes can only be set to objects of the same size");
 
 	std::copy(cube.edges.get(), cube.edges.get() + edge_width*edge_count, edges.get());
 	std::copy(cube.corners.get(), cube.corners.get() + corner_count, corners.get());
+	paired_edges = cube.paired_edges;
 
 	return *this;
 }
@@ -45,6 +48,30 @@ bool Cube::operator==(const Cube& cube) const {
 
 
 
+void Cube::write(std::ostream& stream) const {
+	stream.write(reinterpret_cast<const char*>(edges.get()), edge_width*edge_count);
+	stream.write(reinterpret_cast<const char*>(corners.get()), corner_count);
+}
+
+void Cube::read(std::istream& stream) {
+	stream.read(reinterpret_cast<char*>(edges.get()), edge_width*edge_count);
+	stream.read(reinterpret_cast<char*>(corners.get()), corner_count);
+	update_paired_edges();
+}
+
+void Cube::update_paired_edge(const int edge) {
+	//the position and orientation are the whole byte, so an edge is paired when all of its bytes are equal
+	const uint8_t* first = edges.get() + edge*edge_width;
+	bool paired = edge_width == 0 || std::all_of(first + 1, first + edge_width, [first](const uint8_t piece) {return piece == *first;});
+	paired_edges = (paired_edges & ~(1 << edge)) | (paired << edge);
+}
+
+void Cube::update_paired_edges() {
+	for (int edge = 0; edge < edge_count; edge++) {
+		update_paired_edge(edge);
+	}
+}
+
 void Cube::rotate_face(const Face face, const int degrees) {
 	//map specifies the indicies of the corner pieces that exist in each face.
 	//
@@ -147,6 +174,10 @@ void Cube::rotate_face(const Face face, const int degrees) {
 			flip_edge(current_shifts[j], face);	
 		}
 	}
+
+	for (int edge : edge_shifts) {
+		update_paired_edge(edge);
+	}
 }
 
 void Cube::rotate_slice(const Face face, const int layer, const int degrees) {
@@ -192,6 +223,10 @@ void Cube::rotate_slice(const Face face, const int layer, const int degrees) {
 	
 	//the edges are moved 
 	shift_pieces(edges.get(), edge_shifts, degrees);
+
+	for (int edge : slice_edges[face]) {
+		update_paired_edge(edge);
+	}
 }
 
 void Cube::rotate(const Twist& twist) {
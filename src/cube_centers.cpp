@@ -5,14 +5,68 @@
 #include <unordered_set>
 #include <vector>
 #include <algorithm>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 using namespace cube;
 
+namespace {
+	//counts the pieces in the given array that are equal to 'value_1' and to 'value_2', adding the counts
+	//to 'matches_1' and 'matches_2'. The pieces are compared 16 at a time with SSE2, and the pieces left 
+	//over one at a time
+	void count_matching_pieces(const uint8_t* pieces, const int piece_count, const uint8_t value_1, const uint8_t value_2, int& matches_1, int& matches_2) {
+		int i = 0;
+#if defined(__SSE2__)
+		__m128i values_1 = _mm_set1_epi8(value_1);
+		__m128i values_2 = _mm_set1_epi8(value_2);
+		for (; i+16 <= piece_count; i += 16) {
+			__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pieces+i));
+			matches_1 += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(block, values_1)));
+			matches_2 += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(block, values_2)));
+		}
+#endif
+		for (; i < piece_count; i++) {
+			matches_1 += pieces[i] == value_1;
+			matches_2 += pieces[i] == value_2;
+		}
+	}
+
+#if defined(__x86_64__) || defined(__i386__)
+	//AVX2 version of count_matching_pieces that compares 32 pieces at a time. It is only called
+	//on processors that support AVX2, so the rest of the program doesn't need to be built for them
+	__attribute__((target("avx2")))
+	void count_matching_pieces_avx2(const uint8_t* pieces, const int piece_count, const uint8_t value_1, const uint8_t value_2, int& matches_1, int& matches_2) {
+		int i = 0;
+		__m256i values_1 = _mm256_set1_epi8(value_1);
+		__m256i values_2 = _mm256_set1_epi8(value_2);
+		for (; i+32 <= piece_count; i += 32) {
+			__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pieces+i));
+			matches_1 += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, values_1)));
+			matches_2 += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, values_2)));
+		}
+		count_matching_pieces(pieces+i, piece_count-i, value_1, value_2, matches_1, matches_2);
+	}
+#endif
+
+	typedef void (*MatchCounter)(const uint8_t*, const int, const uint8_t, const uint8_t, int&, int&);
+
+	//returns the fastest version of count_matching_pieces the processor supports
+	MatchCounter select_match_counter() {
+#if defined(__x86_64__) || defined(__i386__)
+		if (__builtin_cpu_supports("avx2")) {
+			return count_matching_pieces_avx2;
+		}
+#endif
+		return count_matching_pieces;
+	}
+}
+
 CubeCenters::CubeCenters(const int size) : 
 	CubeBase(size),
 	center_size(std::pow(edge_width,2)),
-	centers(std::make_unique<uint8_t[]>(center_size*cube::ALL_FACES.size())), 
-	width_in_cartesian_space(size-1) {
+	width_in_cartesian_space(size-1),
+	centers(std::make_unique<uint8_t[]>(center_size*cube::ALL_FACES.size())) {
 
 	if (size%2 == 0) {
 		solved_center_values = std::make_unique<cube::CubeCenters>(3);
@@ -20,13 +74,18 @@ CubeCenters::CubeCenters(const int size) :
 	for (int i = 0; i < center_size*face_count; i++) {
 		centers[i] = i/center_size;
 	}
+	count_pieces();
 }
 
 CubeCenters::CubeCenters(const CubeCenters& cube) : 
 	CubeBase(cube),
 	center_size(cube.center_size),
+	width_in_cartesian_space(cube.width_in_cartesian_space),
 	centers(copy_pieces(cube.centers.get(), center_size*face_count)),
-	width_in_cartesian_space(cube.width_in_cartesian_space) {
+	solved_values(cube.solved_values),
+	opposed_values(cube.opposed_values),
+	solved_pieces(cube.solved_pieces),
+	opposed_pieces(cube.opposed_pieces) {
 		if (cube.solved_center_values != nullptr) {
 			solved_center_values = std::make_unique<cube::CubeCenters>(*cube.solved_center_values);
 		}
@@ -36,9 +95,20 @@ CubeCenters& CubeCenters::operator=(const CubeCenters& cube) {
 	assert(cube.size == size && "Cube classes can only be set to objects of the same size");
 	
 	std::copy(cube.centers.get(), cube.centers.get() + center_size*face_count, centers.get());
+	//cubes of the same size either both have solved center values or both don't, so they are copied
+	//into the ones already allocated
 	if (cube.solved_center_values != nullptr) {
-		solved_center_values = std::make_unique<cube::CubeCenters>(*cube.solved_center_values);
+		if (solved_center_values != nullptr) {
+			*solved_center_values = *cube.solved_center_values;
+		}
+		else {
+			solved_center_values = std::make_unique<cube::CubeCenters>(*cube.solved_center_values);
+		}
 	}	
+	solved_values = cube.solved_values;
+	opposed_values = cube.opposed_values;
+	solved_pieces = cube.solved_pieces;
+	opposed_pieces = cube.opposed_pieces;
 
 	return *this;
 }
@@ -91,7 +161,24 @@ void CubeCenters::rotate_face(const Face face, const int degrees) {
 	}
 }
 
-void CubeCenters::rotate_slice(const Face slice_face, const int layer, const int degrees) {
+void CubeCenters::count_pieces() {
+	for (const auto face : ALL_FACES) {
+		solved_values[static_cast<int>(face)] = get_solved_center_value(face);
+	}
+	for (const auto face : ALL_FACES) {
+		opposed_values[static_cast<int>(face)] = solved_values[static_cast<int>(OPPOSING_FACES.at(face))];
+	}
+	static const MatchCounter count_matches = select_match_counter();
+	solved_pieces = 0;
+	opposed_pieces = 0;
+	for (const auto face : ALL_FACES) {
+		int face_index = static_cast<int>(face);
+		count_matches(centers.get() + face_index*center_size, center_size, solved_values[face_index], opposed_values[face_index], 
+				solved_pieces, opposed_pieces);
+	}
+}
+
+void CubeCenters::rotate_slice(const Face slice_face, const int layer, const int degrees, const bool update_counts) {
 	///map specifies the the centers that exist in each slice
 	//
 	//the indecies of the center pieces in the slice are listed as follows:
@@ -167,7 +254,17 @@ void CubeCenters::rotate_slice(const Face slice_face, const int layer, const int
 			//the coordinates determined above are converted to a piece index
 			piece_shifts[i] = center_size*static_cast<int>(current_face) + (piece_coords[1]-1)*edge_width + piece_coords[0]-1;
 		}	
+		if (update_counts) {
+			for (int i = 0; i < 4; i++) {
+				count_piece(piece_shifts[i], center_shifts[i], -1);
+			}
+		}
 		shift_pieces(centers.get(), piece_shifts, degrees);
+		if (update_counts) {
+			for (int i = 0; i < 4; i++) {
+				count_piece(piece_shifts[i], center_shifts[i], 1);
+			}
+		}
 	}
 }
 
@@ -199,7 +296,42 @@ int CubeCenters::get_solved_center_value(const Face face) const {
 	}
 }
 
+void CubeCenters::write(std::ostream& stream) const {
+	stream.write(reinterpret_cast<const char*>(centers.get()), center_size*face_count);
+	if (solved_center_values != nullptr) {
+		solved_center_values->write(stream);
+	}
+}
+
+void CubeCenters::read(std::istream& stream) {
+	stream.read(reinterpret_cast<char*>(centers.get()), center_size*face_count);
+	if (solved_center_values != nullptr) {
+		solved_center_values->read(stream);
+	}
+	count_pieces();
+}
+
+std::size_t CubeCenters::get_memory_usage() const {
+	std::size_t memory_usage = sizeof(CubeCenters) + center_size*face_count;
+	if (solved_center_values != nullptr) {
+		memory_usage += solved_center_values->get_memory_usage();
+	}
+
+	return memory_usage;
+}
+
 void CubeCenters::rotate(const Twist& twist) {
+	//rotations of the whole cube, and on odd cubes rotations of the middle slice, move the pieces 
+	//that determine the solved value of each face, so the piece counts are recomputed. Otherwise 
+	//only the pieces moved between faces are counted again, as face rotations keep pieces on their face
+	bool moves_solved_values;
+	if (solved_center_values != nullptr) {
+		moves_solved_values = twist.layer == size-1 && twist.wide_turn;
+	}
+	else {
+		int middle_layer = size/2;
+		moves_solved_values = twist.layer == middle_layer || (twist.wide_turn && twist.layer > middle_layer);
+	}
 	if (solved_center_values != nullptr && twist.layer == size-1 && twist.wide_turn) {
 		solved_center_values -> rotate(Twist(twist.degrees, twist.face, 1, false));	
 	}
@@ -211,7 +343,10 @@ void CubeCenters::rotate(const Twist& twist) {
 			rotate(Twist(-twist.degrees, OPPOSING_FACES.at(twist.face)));
 		}
 		else {
-			rotate_slice(twist.face, i, twist.degrees);
+			rotate_slice(twist.face, i, twist.degrees, !moves_solved_values);
 		}	
 	}
+	if (moves_solved_values) {
+		count_pieces();
+	}
 }	
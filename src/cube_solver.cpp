@@ -1,22 +1,243 @@
 #include "cube_solver.h"
 #include "three_cube_solver.h"
-#include "edge_solver.h"
-#include "center_solver.h"
+#include "checkpoint.h"
+#include "hash.h"
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <algorithm>
 
 using namespace ai;
 
-void CubeSolver::solve(const cube::CombinedCube& comb_cube) {
+namespace {
+	//records the twists made by a solver racing in the portfolio, and forwards the improved solutions it
+	//reports to 'improvement_listener' if one is set
+	struct TwistRecorder : public TwistListener {
+		std::vector<cube::Twist> twists;
+		TwistListener* improvement_listener = nullptr;
+
+		void twist(const cube::Twist& twist) override {
+			twists.push_back(twist);
+		}
+
+		void solution_improved(const std::vector<cube::Twist>& twists) override {
+			if (improvement_listener != nullptr) {
+				improvement_listener->solution_improved(twists);
+			}
+		}
+	};
+}
+
+search::SearchResult CubeSolver::race(const StageSolver& solve_stage) {
+	if (portfolio.size() == 1) {
+		return solve_stage(portfolio.front(), limits);
+	}
+
+	//the racing searches watch their own token, which is set when the race ends or the 
+	//searches are stopped by the caller's limits. Racing searches would overwrite each
+	//other's checkpoints, so only the stages are checkpointed
+	search::CancellationToken race_cancellation(false);
+	search::SearchLimits race_limits(limits);
+	race_limits.cancellation_token = &race_cancellation;
+	race_limits.checkpoint = boost::none;
+
+	std::mutex results_mutex;
+	std::condition_variable result_added;
+	std::vector<boost::optional<search::SearchResult>> results(portfolio.size());
+	std::exception_ptr error;
+	std::vector<std::thread> threads;
+	for (std::size_t i = 0; i < portfolio.size(); i++) {
+		threads.emplace_back([&, i]() {
+			boost::optional<search::SearchResult> result;
+			std::exception_ptr entry_error;
+			try {
+				result = solve_stage(portfolio[i], race_limits);
+			}
+			catch (...) {
+				entry_error = std::current_exception();
+			}
+			std::lock_guard<std::mutex> lock(results_mutex);
+			if (result) {
+				results[i] = std::move(result);
+			}
+			else {
+				results[i] = search::SearchResult(search::SearchStatus::CANCELLED, std::vector<cube::Twist>());
+				error = entry_error;
+			}
+			result_added.notify_one();
+		});
+	}
+
+	{
+		//the caller's cancellation token can't wake this thread, so the limits are polled
+		std::unique_lock<std::mutex> lock(results_mutex);
+		//the selection window opens when the first entry solves the stage
+		bool window_open = false;
+		std::chrono::steady_clock::time_point selection_deadline = std::chrono::steady_clock::time_point::max();
+		while (true) {
+			bool all_finished = std::all_of(results.begin(), results.end(), [](const boost::optional<search::SearchResult>& result) {
+				return result.is_initialized();
+			});
+			if (all_finished || limits.check()) {
+				break;
+			}
+			if (!window_open) {
+				for (std::size_t i = 0; i < results.size(); i++) {
+					if (results[i] && results[i]->solved()) {
+						std::cout << "Portfolio entry " << i << " finished first\n";
+						window_open = true;
+						selection_deadline = std::chrono::steady_clock::now() + selection_window;
+						break;
+					}
+				}
+			}
+			if (window_open && std::chrono::steady_clock::now() >= selection_deadline) {
+				break;
+			}
+			result_added.wait_for(lock, std::chrono::milliseconds(10));
+		}
+	}
+	race_cancellation = true;
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	//index of the entry with the shortest solution, or -1 if no entry solved the stage
+	int best_entry = -1;
+	for (std::size_t i = 0; i < results.size(); i++) {
+		if (results[i]->solved() && (best_entry == -1 || results[i]->twists.size() < results[best_entry]->twists.size())) {
+			best_entry = i;
+		}
+	}
+	if (best_entry == -1) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+		//searches cancelled by the race report the caller's reason for stopping
+		auto status = limits.check();
+		return search::SearchResult(status ? *status : results.front()->status, results.front()->twists);
+	}
+	std::cout << "Keeping the solution of portfolio entry " << best_entry << " (" << results[best_entry]->twists.size() << " twists)\n";
+	
+	return *results[best_entry];
+}
+
+void CubeSolver::save_checkpoint(const boost::filesystem::path& file_path, const cube::CombinedCube& initial_cube, const int completed_stages) {
+	search::checkpoint::save(file_path, [&](std::ostream& stream) {
+		search::checkpoint::write_header(stream, initial_cube.get_cube().get_size());
+		initial_cube.get_cube().write(stream);
+		initial_cube.get_cube_centers().write(stream);
+		search::checkpoint::write_value<int32_t>(stream, completed_stages);
+		search::checkpoint::write_twists(stream, solve_twists);
+	});
+}
+
+int CubeSolver::load_checkpoint(const boost::filesystem::path& file_path, const cube::CombinedCube& initial_cube) {
+	std::ifstream file(file_path.string(), std::ifstream::binary);
+	if (!file) {
+		return 0;
+	}
+	try {
+		//the initial cube is stored in full, so a hash collision can't resume the wrong solve
+		cube::CombinedCube saved_cube(initial_cube);
+		if (!search::checkpoint::read_header(file, initial_cube.get_cube().get_size())) {
+			throw std::runtime_error("Checkpoint was written by a different version");
+		}
+		saved_cube.get_cube().read(file);
+		saved_cube.get_cube_centers().read(file);
+		if (!file || !(saved_cube == initial_cube)) {
+			throw std::runtime_error("Checkpoint belongs to a different cube");
+		}
+		int completed_stages = search::checkpoint::read_value<int32_t>(file);
+		auto twists = search::checkpoint::read_twists(file);
+		std::cout << "Resuming solve from " << file_path.string() << " after " << completed_stages << " stages\n";
+		for (const auto& twst : twists) {
+			twist(twst);
+		}
+
+		return completed_stages;
+	}
+	catch (const std::runtime_error& error) {
+		std::cout << "Ignoring checkpoint " << file_path.string() << ": " << error.what() << "\n";
+		return 0;
+	}
+}
+
+search::SearchStatus CubeSolver::solve(const cube::CombinedCube& comb_cube) {
 	this->comb_cube = comb_cube;
+	solve_twists.clear();
+
+	boost::optional<boost::filesystem::path> checkpoint_path;
+	int completed_stages = 0;
+	if (limits.checkpoint) {
+		std::size_t key = std::hash<cube::Cube>()(comb_cube.get_cube());
+		boost::hash_combine(key, std::hash<cube::CubeCenters>()(comb_cube.get_cube_centers()));
+		checkpoint_path = limits.checkpoint->file_path("solve", key);
+		completed_stages = load_checkpoint(*checkpoint_path, comb_cube);
+	}
+	auto complete_stage = [&]() {
+		if (checkpoint_path) {
+			save_checkpoint(*checkpoint_path, comb_cube, ++completed_stages);
+		}
+	};
+
+	//a stage is applied to the cube once it has been solved, or stopped with the twists that lead 
+	//closest to a solution
+	auto apply_stage = [this](const search::SearchResult& result) {
+		for (const auto& twst : result.twists) {
+			twist(twst);
+		}
+		return result.status;
+	};
 
-	CenterSolver center_solver;
-	center_solver.add_twist_listener(this);
-	center_solver.solve(this->comb_cube.get().get_cube_centers());
+	//improved solutions are forwarded to the listeners when there is no race, since racing solvers report them
+	//from their own threads, and the solutions of the losing entries are thrown away
+	TwistListener* improvement_listener = portfolio.size() == 1 ? this : nullptr;
 
-	EdgeSolver edge_solver;
-	edge_solver.add_twist_listener(this);
-	edge_solver.solve(this->comb_cube.get().get_cube());
+	if (completed_stages < 1) {
+		const auto& centers = this->comb_cube.get().get_cube_centers();
+		auto status = apply_stage(race([&centers, improvement_listener](const PortfolioEntry& entry, const search::SearchLimits& stage_limits) {
+			CenterSolver center_solver(stage_limits, entry.center_settings);
+			TwistRecorder recorder;
+			recorder.improvement_listener = improvement_listener;
+			center_solver.add_twist_listener(&recorder);
+			auto status = center_solver.solve(centers);
+			return search::SearchResult(status, recorder.twists);
+		}));
+		if (status != search::SearchStatus::SOLVED) {
+			return status;
+		}
+		complete_stage();
+	}
+
+	if (completed_stages < 2) {
+		const auto& cube = this->comb_cube.get().get_cube();
+		auto status = apply_stage(race([&cube, improvement_listener](const PortfolioEntry& entry, const search::SearchLimits& stage_limits) {
+			EdgeSolver edge_solver(stage_limits, entry.edge_settings);
+			TwistRecorder recorder;
+			recorder.improvement_listener = improvement_listener;
+			edge_solver.add_twist_listener(&recorder);
+			auto status = edge_solver.solve(cube);
+			return search::SearchResult(status, recorder.twists);
+		}));
+		if (status != search::SearchStatus::SOLVED) {
+			return status;
+		}
+		complete_stage();
+	}
 	
+	if (auto limit_status = limits.check()) {
+		return *limit_status;
+	}
 	ThreeCubeSolver three_solver;
 	three_solver.add_twist_listener(this);
 	three_solver.solve(this->comb_cube.get());
+	if (checkpoint_path) {
+		search::checkpoint::remove(*checkpoint_path);
+	}
+
+	return search::SearchStatus::SOLVED;
 }
@@ -0,0 +1,243 @@
+#include "edge_pattern_database.h"
+#include "checkpoint.h"
+#include "twist_utils.h"
+#include "twist.h"
+#include <algorithm>
+#include <functional>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace ai;
+using namespace search;
+
+constexpr uint32_t EdgePatternDatabase::magic;
+constexpr uint32_t EdgePatternDatabase::version;
+
+std::vector<EdgePatternDatabase::Group> EdgePatternDatabase::find_groups(const int size) {
+	int edge_width = cube::Cube(size).get_edge_width();
+	std::vector<Group> groups;
+	for (int slot = 0; slot < edge_width/2; slot++) {
+		Group group;
+		for (int edge = 0; edge < edge_count; edge++) {
+			group.push_back(edge*edge_width + slot);
+			group.push_back(edge*edge_width + edge_width - 1 - slot);
+		}
+		if (edge_width%2 != 0) {
+			for (int edge = 0; edge < edge_count; edge++) {
+				group.push_back(edge*edge_width + edge_width/2);
+			}
+		}
+		groups.push_back(group);
+	}
+
+	return groups;
+}
+
+std::vector<uint8_t> EdgePatternDatabase::generate_distances(const int middle_count, const std::vector<PatternMove>& moves) {
+	int pattern_count = wing_states*wing_states*middle_count;
+
+	//the search runs backwards from the paired patterns, so each move is inverted
+	std::vector<PatternMove> inverse_moves(moves);
+	for (int i = 0; i < moves.size(); i++) {
+		for (int position = 0; position < moves[i].positions.size(); position++) {
+			inverse_moves[i].positions[moves[i].positions[position]] = position;
+			inverse_moves[i].flips[moves[i].positions[position]] = moves[i].flips[position];
+		}
+	}
+
+	//moves differ in cost, so the patterns are expanded in order of distance from a bucket for each distance.
+	//Distances are stored in a byte, and patterns that can't be reached in fewer than 255 twists are left at 255.
+	//Indices with the higher wing state not above the lower one aren't patterns, and are never reached
+	const int unreached = 255;
+	std::vector<uint8_t> distances(pattern_count, unreached);
+	std::vector<std::vector<int>> buckets(unreached);
+	for (int edge = 0; edge < edge_count; edge++) {
+		for (int orientation = 0; orientation < 2; orientation++) {
+			int lower = (2*edge)*2 + orientation;
+			int higher = (2*edge + 1)*2 + orientation;
+			int middle = middle_count == 1 ? 0 : edge*2 + orientation;
+			int pattern = (lower*wing_states + higher)*middle_count + middle;
+			distances[pattern] = 0;
+			buckets[0].push_back(pattern);
+		}
+	}
+
+	for (int distance = 0; distance < unreached; distance++) {
+		for (const int pattern : buckets[distance]) {
+			if (distances[pattern] != distance) {
+				continue;
+			}
+			int middle = pattern%middle_count;
+			int lower = pattern/middle_count/wing_states;
+			int higher = pattern/middle_count%wing_states;
+			for (const auto& move : inverse_moves) {
+				int previous_distance = distance + move.cost;
+				if (previous_distance >= unreached) {
+					continue;
+				}
+				//returns the state of the wing with the given state before the move. Middle wings follow the
+				//paired wings in the group
+				auto previous_state = [&move](const int state, const int offset) {
+					int position = state/2 + offset;
+					return (move.positions[position] - offset)*2 + ((state%2) ^ move.flips[position]);
+				};
+				int previous_lower = previous_state(lower, 0);
+				int previous_higher = previous_state(higher, 0);
+				if (previous_lower > previous_higher) {
+					std::swap(previous_lower, previous_higher);
+				}
+				int previous_middle = middle_count == 1 ? 0 : previous_state(middle, paired_positions);
+				int previous_pattern = (previous_lower*wing_states + previous_higher)*middle_count + previous_middle;
+				if (previous_distance < distances[previous_pattern]) {
+					distances[previous_pattern] = previous_distance;
+					buckets[previous_distance].push_back(previous_pattern);
+				}
+			}
+		}
+		std::vector<int>().swap(buckets[distance]);
+	}
+
+	return distances;
+}
+
+void EdgePatternDatabase::generate(const boost::filesystem::path& file_path, const int size, const std::vector<TwistSequence>& twist_sequences,
+		const std::size_t key) {
+	int edge_width = cube::Cube(size).get_edge_width();
+	int middle_count = edge_width%2 != 0 ? middle_states : 1;
+	auto groups = find_groups(size);
+
+	std::vector<std::vector<std::pair<int, bool>>> destinations;
+	for (const auto& twist_seq : twist_sequences) {
+		destinations.push_back(TwistUtils::trace_wings(size, twist_seq));
+	}
+
+	checkpoint::save(file_path, [&](std::ostream& file) {
+		checkpoint::write_value(file, magic);
+		checkpoint::write_value(file, version);
+		checkpoint::write_value<uint32_t>(file, size);
+		checkpoint::write_value<uint64_t>(file, key);
+		checkpoint::write_value<uint32_t>(file, groups.size());
+
+		for (const auto& group : groups) {
+			std::vector<int> group_indices(edge_width*edge_count, -1);
+			for (int i = 0; i < group.size(); i++) {
+				group_indices[group[i]] = i;
+			}
+			//TwistSequences that move the group the same way only need to be searched once, with the lowest cost
+			std::vector<PatternMove> moves;
+			for (int i = 0; i < twist_sequences.size(); i++) {
+				PatternMove move;
+				for (const int position : group) {
+					move.positions.push_back(group_indices[destinations[i][position].first]);
+					move.flips.push_back(destinations[i][position].second);
+				}
+				move.cost = twist_sequences[i].size();
+
+				auto same_move = std::find_if(moves.begin(), moves.end(), [&move](const PatternMove& other) {
+					return other.positions == move.positions && other.flips == move.flips;
+				});
+				if (same_move == moves.end()) {
+					moves.push_back(move);
+				}
+				else {
+					same_move->cost = std::min(same_move->cost, move.cost);
+				}
+			}
+
+			auto distances = generate_distances(middle_count, moves);
+			file.write(reinterpret_cast<const char*>(distances.data()), distances.size());
+		}
+	});
+}
+
+EdgePatternDatabase::EdgePatternDatabase(const boost::filesystem::path& file_path, const int size, const std::vector<TwistSequence>& twist_sequences,
+		const PatternCombination combination) :
+	edge_width(cube::Cube(size).get_edge_width()),
+	middle_count(edge_width%2 != 0 ? middle_states : 1),
+	pattern_count(wing_states*wing_states*middle_count),
+	groups(find_groups(size)),
+	combination(combination) {
+	std::size_t key = checkpoint::hash_twist_sequences(twist_sequences);
+
+	//returns true if the file starts with a header written for the given size and TwistSequences
+	auto read_header = [this, &file_path, size, key]() {
+		std::ifstream stream(file_path.string(), std::ifstream::binary);
+		try {
+			return checkpoint::read_value<uint32_t>(stream) == magic && checkpoint::read_value<uint32_t>(stream) == version &&
+				checkpoint::read_value<uint32_t>(stream) == size && checkpoint::read_value<uint64_t>(stream) == key &&
+				checkpoint::read_value<uint32_t>(stream) == groups.size();
+		}
+		catch (const std::runtime_error&) {
+			return false;
+		}
+	};
+
+	{
+		//solvers racing in other threads or processes may load the same database, which is only generated once
+		checkpoint::FileLock lock(file_path);
+		if (!boost::filesystem::exists(file_path) || !read_header()) {
+			std::cout << "Generating the edge pattern database " << file_path.string() << ". This may take some time.\n";
+			generate(file_path, size, twist_sequences, key);
+			if (!read_header()) {
+				throw std::runtime_error("Couldn't read pattern database " + file_path.string());
+			}
+			std::cout << "Edge pattern database generated\n";
+		}
+	}
+
+	file.open(file_path.string());
+	std::size_t header_length = 3*sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint32_t);
+	if (file.size() != header_length + groups.size()*pattern_count) {
+		throw std::runtime_error("Pattern database " + file_path.string() + " has the wrong size");
+	}
+	for (int i = 0; i < groups.size(); i++) {
+		distances.push_back(reinterpret_cast<const uint8_t*>(file.data()) + header_length + i*pattern_count);
+	}
+}
+
+int EdgePatternDatabase::operator()(const cube::Cube& cube, const int ignored_pieces) const {
+	auto combine = [this](const int estimate, const int distance) {
+		return combination == PatternCombination::SUM ? estimate + distance : std::max(estimate, distance);
+	};
+
+	//the combined distance of each piece's patterns
+	std::array<int, edge_count> piece_distances = {};
+	for (int i = 0; i < groups.size(); i++) {
+		//the states of the wings of each piece in the group. The positions are visited in increasing order,
+		//so the first wing found of a piece is its lower wing
+		std::array<int, edge_count> lower_wings;
+		std::array<int, edge_count> higher_wings;
+		std::array<int, edge_count> middle_wings = {};
+		lower_wings.fill(-1);
+		for (int position = 0; position < paired_positions; position++) {
+			int wing = groups[i][position];
+			int piece = cube.get_edge_pos(wing);
+			int state = position*2 + cube.get_edge_orientation(wing);
+			if (lower_wings[piece] == -1) {
+				lower_wings[piece] = state;
+			}
+			else {
+				higher_wings[piece] = state;
+			}
+		}
+		if (middle_count != 1) {
+			for (int position = 0; position < middle_positions; position++) {
+				int wing = groups[i][paired_positions + position];
+				middle_wings[cube.get_edge_pos(wing)] = position*2 + cube.get_edge_orientation(wing);
+			}
+		}
+		for (int piece = 0; piece < edge_count; piece++) {
+			int pattern = (lower_wings[piece]*wing_states + higher_wings[piece])*middle_count + middle_wings[piece];
+			piece_distances[piece] = combine(piece_distances[piece], distances[i][pattern]);
+		}
+	}
+
+	std::sort(piece_distances.begin(), piece_distances.end());
+	int estimate = 0;
+	for (int piece = 0; piece < edge_count - ignored_pieces; piece++) {
+		estimate = combine(estimate, piece_distances[piece]);
+	}
+
+	return estimate;
+}
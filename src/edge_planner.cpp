@@ -0,0 +1,259 @@
+#include "edge_planner.h"
+#include "cube_centers.h"
+#include "twist_utils.h"
+#include "twist.h"
+#include "face.h"
+#include <map>
+#include <tuple>
+#include <stdexcept>
+#include <algorithm>
+
+using namespace ai;
+
+std::vector<TwistSequence> EdgePlanner::generate_setups(const int depth) const {
+	std::vector<TwistSequence> setups = {TwistSequence()};
+	std::map<std::vector<std::pair<int, bool>>, int> seen_setups = {{TwistUtils::trace_wings(size, {}), 0}};
+	auto face_twists = TwistUtils::generate_face_twists();
+	for (int begin = 0, curr_depth = 0; curr_depth < depth; curr_depth++) {
+		int end = setups.size();
+		for (int i = begin; i < end; i++) {
+			for (const auto& face_twist : face_twists) {
+				TwistSequence setup(setups[i]);
+				setup.insert(setup.end(), face_twist.begin(), face_twist.end());
+				if (seen_setups.emplace(TwistUtils::trace_wings(size, setup), setups.size()).second) {
+					setups.push_back(setup);
+				}
+			}
+		}
+		begin = end;
+	}
+
+	return setups;
+}
+
+std::vector<TwistSequence> EdgePlanner::generate_slice_moves() const {
+	using namespace cube;
+	std::vector<TwistSequence> slice_moves;
+	for (const auto axis : TwistUtils::AXIS_FACES) {
+		for (int layer = 1; layer < size-1; layer++) {
+			for (const int slice_degrees : TwistUtils::DEGREES) {
+				Twist slice(slice_degrees, axis, layer, false);
+				for (const auto turning_face : {axis, OPPOSING_FACES.at(axis)}) {
+					for (const auto replacing_face : ALL_FACES) {
+						if (replacing_face == axis || replacing_face == OPPOSING_FACES.at(axis)) {
+							continue;
+						}
+						for (const int turning_degrees : TwistUtils::DEGREES) {
+							for (const int replacing_degrees : TwistUtils::DEGREES) {
+								//the trigger replaces the edge the slice brought a wing into, and is undone after the slice
+								TwistSequence trigger = {
+									Twist(replacing_degrees, replacing_face),
+									Twist(turning_degrees, turning_face),
+									Twist(-replacing_degrees, replacing_face)
+								};
+								TwistSequence slice_move = {slice};
+								slice_move.insert(slice_move.end(), trigger.begin(), trigger.end());
+								slice_move.push_back(Twist(-slice_degrees, axis, layer, false));
+								auto undo_trigger = TwistUtils::invert(trigger);
+								slice_move.insert(slice_move.end(), undo_trigger.begin(), undo_trigger.end());
+								slice_moves.push_back(slice_move);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return slice_moves;
+}
+
+EdgePlanner::EdgePlanner(const int size, const int setup_depth) : size(size) {
+	cube::Cube solved(size);
+	int edge_width = solved.get_edge_width();
+	int wing_count = edge_width*solved.get_edge_count();
+
+	//the position each setup moves each wing to, and the position each wing is moved from by it
+	auto setups = generate_setups(setup_depth);
+	std::vector<std::vector<std::pair<int, bool>>> setup_destinations;
+	std::vector<std::vector<std::pair<int, bool>>> setup_sources;
+	for (const auto& setup : setups) {
+		auto destinations = TwistUtils::trace_wings(size, setup);
+		std::vector<std::pair<int, bool>> sources(wing_count);
+		for (int wing = 0; wing < wing_count; wing++) {
+			sources[destinations[wing].first] = {wing, destinations[wing].second};
+		}
+		setup_destinations.push_back(destinations);
+		setup_sources.push_back(sources);
+	}
+
+	//slice moves that disturb the centers are left out, and the middle wings of odd cubes are never moved
+	std::vector<TwistSequence> slice_moves;
+	std::vector<std::vector<std::pair<int, bool>>> slice_destinations;
+	for (const auto& slice_move : generate_slice_moves()) {
+		cube::CubeCenters centers(size);
+		for (const auto& twist : slice_move) {
+			centers.rotate(twist);
+		}
+		if (centers.get_solved_piece_count() == centers.get_pieces_in_center()*cube::ALL_FACES.size()) {
+			slice_moves.push_back(slice_move);
+			slice_destinations.push_back(TwistUtils::trace_wings(size, slice_move));
+		}
+	}
+
+	//the setups are tried shortest first, so each way of moving the wings is kept with its shortest twists
+	moves_into.resize(wing_count);
+	std::map<std::vector<std::tuple<int, int, bool>>, int> seen_moves;
+	for (int setup = 0; setup < setups.size(); setup++) {
+		for (int slice_move = 0; slice_move < slice_moves.size(); slice_move++) {
+			WingMove move;
+			std::vector<std::tuple<int, int, bool>> key;
+			bool moves_middle_wing = false;
+			for (int wing = 0; wing < wing_count; wing++) {
+				const auto& after_setup = setup_destinations[setup][wing];
+				const auto& after_slice_move = slice_destinations[slice_move][after_setup.first];
+				const auto& after_undo = setup_sources[setup][after_slice_move.first];
+				bool flipped = after_setup.second ^ after_slice_move.second ^ after_undo.second;
+				if (after_undo.first != wing || flipped) {
+					move.moved_wings.push_back({static_cast<uint8_t>(wing), static_cast<uint8_t>(after_undo.first), flipped});
+					key.emplace_back(wing, after_undo.first, flipped);
+					moves_middle_wing = moves_middle_wing || (edge_width%2 != 0 && wing%edge_width == edge_width/2);
+				}
+			}
+			if (key.empty() || moves_middle_wing || !seen_moves.emplace(key, moves.size()).second) {
+				continue;
+			}
+			move.twists = setups[setup];
+			move.twists.insert(move.twists.end(), slice_moves[slice_move].begin(), slice_moves[slice_move].end());
+			auto undo_setup = TwistUtils::invert(setups[setup]);
+			move.twists.insert(move.twists.end(), undo_setup.begin(), undo_setup.end());
+			for (const auto& moved_wing : move.moved_wings) {
+				moves_into[moved_wing.destination].push_back(moves.size());
+			}
+			moves.push_back(move);
+		}
+	}
+}
+
+search::SearchResult EdgePlanner::solve(const cube::Cube& cube, const search::SearchLimits& limits) const {
+	if (cube.get_size() != size) {
+		throw std::invalid_argument("The cube must be the size the planner was built for");
+	}
+	int edge_width = cube.get_edge_width();
+	int edge_count = cube.get_edge_count();
+
+	cube::Cube state(cube);
+	auto wing_value = [&state](const int position) {
+		return state.get_edge_pos(position) | state.get_edge_orientation(position) << 7;
+	};
+
+	//wings that are paired or are the middle wings of odd cubes are locked, and are never moved again
+	std::vector<bool> locked_wings(edge_width*edge_count);
+	std::vector<bool> paired_edges(edge_count);
+	std::vector<bool> used_pieces(edge_count);
+	if (edge_width%2 != 0) {
+		for (int edge = 0; edge < edge_count; edge++) {
+			locked_wings[edge*edge_width + edge_width/2] = true;
+		}
+	}
+
+	std::vector<cube::Twist> twists;
+	for (int paired_count = 0; paired_count < edge_count-2; paired_count++) {
+		//the edge paired next is the one with the most wings matching a piece and orientation that isn't
+		//paired yet. On odd cubes, the middle wing gives the piece and orientation
+		int best_edge = -1;
+		int best_value = -1;
+		int best_matches = -1;
+		for (int edge = 0; edge < edge_count; edge++) {
+			if (paired_edges[edge]) {
+				continue;
+			}
+			for (int slot = 0; slot < edge_width; slot++) {
+				int value = wing_value(edge*edge_width + slot);
+				if (used_pieces[value & 0x7F] || (edge_width%2 != 0 && slot != edge_width/2)) {
+					continue;
+				}
+				int matches = 0;
+				for (int i = 0; i < edge_width; i++) {
+					matches += wing_value(edge*edge_width + i) == value;
+				}
+				if (matches > best_matches) {
+					best_edge = edge;
+					best_value = value;
+					best_matches = matches;
+				}
+			}
+		}
+		if (best_edge == -1) {
+			throw std::runtime_error("No edge can be paired to a piece that isn't paired yet");
+		}
+		paired_edges[best_edge] = true;
+		used_pieces[best_value & 0x7F] = true;
+
+		for (int slot = 0; slot < edge_width; slot++) {
+			int position = best_edge*edge_width + slot;
+			if (wing_value(position) == best_value) {
+				locked_wings[position] = true;
+			}
+		}
+		for (int slot = 0; slot < edge_width; slot++) {
+			int position = best_edge*edge_width + slot;
+			if (locked_wings[position]) {
+				continue;
+			}
+
+			//a breadth-first search follows the wings of the piece through the moves that move no locked wing,
+			//until one of them reaches the position with the orientation of the edge. A state is the position
+			//of a wing times 2, plus its orientation
+			std::vector<bool> usable_moves(moves.size());
+			for (int move = 0; move < moves.size(); move++) {
+				usable_moves[move] = std::none_of(moves[move].moved_wings.begin(), moves[move].moved_wings.end(),
+						[&locked_wings](const WingMove::MovedWing& moved_wing) {return locked_wings[moved_wing.source];});
+			}
+			std::vector<std::pair<int, int>> previous(locked_wings.size()*2, {-2, -1});
+			std::vector<int> queue;
+			for (int wing = 0; wing < locked_wings.size(); wing++) {
+				if (!locked_wings[wing] && (wing_value(wing) & 0x7F) == (best_value & 0x7F)) {
+					queue.push_back(wing*2 + (wing_value(wing) >> 7));
+					previous[queue.back()] = {-1, -1};
+				}
+			}
+			int goal = position*2 + (best_value >> 7);
+			for (int head = 0; head < queue.size() && previous[goal].first == -2; head++) {
+				int wing_state = queue[head];
+				for (const int move : moves_into[wing_state/2]) {
+					if (!usable_moves[move]) {
+						continue;
+					}
+					for (const auto& moved_wing : moves[move].moved_wings) {
+						int next_state = moved_wing.destination*2 + ((wing_state%2) ^ moved_wing.flipped);
+						if (moved_wing.source == wing_state/2 && previous[next_state].first == -2) {
+							previous[next_state] = {move, wing_state};
+							queue.push_back(next_state);
+						}
+					}
+				}
+			}
+			if (previous[goal].first == -2) {
+				throw std::runtime_error("No moves bring a matching wing into wing position " + std::to_string(position));
+			}
+
+			std::vector<int> path;
+			for (int wing_state = goal; previous[wing_state].first != -1; wing_state = previous[wing_state].second) {
+				path.push_back(previous[wing_state].first);
+			}
+			for (auto it = path.rbegin(); it != path.rend(); it++) {
+				if (auto status = limits.check()) {
+					return search::SearchResult(*status, twists);
+				}
+				for (const auto& twist : moves[*it].twists) {
+					state.rotate(twist);
+				}
+				twists.insert(twists.end(), moves[*it].twists.begin(), moves[*it].twists.end());
+			}
+			locked_wings[position] = true;
+		}
+	}
+
+	return search::SearchResult(search::SearchStatus::SOLVED, twists);
+}
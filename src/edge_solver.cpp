@@ -2,69 +2,201 @@
 #include "hash.h"
 #include "search.h"
 #include "twist_utils.h"
-#include <unordered_set>
+#include "cube_centers.h"
 #include <algorithm>
-#include <queue>
+#include <cassert>
 #include <iostream>
 #include <optional>
+#include <thread>
+#include <map>
+#include <stdexcept>
 
 using namespace ai;
 
 int EdgeSolver::EdgeHeuristic::operator()(const cube::Cube& cube) {
-	auto edge_assignment_compare = [](const EdgeAssignment& lhs, const EdgeAssignment& rhs) {
-		return lhs.placed_pieces < rhs.placed_pieces;	
-	};
-	auto map_value_compare = [](const std::pair<int, int>& lhs, const std::pair<int, int>& rhs) {
-		return lhs.second < rhs.second;	
+	constexpr int max_edge_count = 12;
+	assert(cube.get_edge_count() <= max_edge_count);
+
+	//number of wings of each piece in each edge that share the orientation most common among them
+	std::array<std::array<int, max_edge_count>, max_edge_count> placed_pieces;
+	for (int edge = 0; edge < cube.get_edge_count(); edge++) {
+		std::array<std::array<int, 2>, max_edge_count> orientation_counts = {};
+		for (int i = 0; i < cube.get_edge_width(); i++) {
+			int position = edge*cube.get_edge_width()+i;
+			orientation_counts[cube.get_edge_pos(position)][cube.get_edge_orientation(position)]++;
+		}
+		for (int piece = 0; piece < cube.get_edge_count(); piece++) {
+			placed_pieces[edge][piece] = std::max(orientation_counts[piece][0], orientation_counts[piece][1]);
+		}
+	}
+
+	//each possible assignment of a piece to an edge is packed into an int as the number of pieces it places
+	//followed by the piece and the edge. The assignments are kept in a heap ordered only by the number of
+	//pieces placed, so ties are broken the same way regardless of the piece and edge
+	std::array<int, max_edge_count*max_edge_count> possible_assignments;
+	auto assignment_compare = [](const int lhs, const int rhs) {
+		return (lhs >> 8) < (rhs >> 8);
 	};
-	std::priority_queue<EdgeAssignment, std::vector<EdgeAssignment>, decltype(edge_assignment_compare)> possible_assignments(edge_assignment_compare);
+	int assignment_count = 0;
 	for (int piece = 0; piece < cube.get_edge_count(); piece++) {
 		for (int edge = 0; edge < cube.get_edge_count(); edge++) {
-			std::unordered_map<int, int> piece_orientation_counts;
-			for (int i = 0; i < cube.get_edge_width(); i++) {
-				int position = edge*cube.get_edge_width()+i;
-				if (cube.get_edge_pos(position) == piece) {
-					piece_orientation_counts[cube.get_edge_orientation(position)]++;
-				}
-			}
-			int placed_pieces = 0;
-			if (!piece_orientation_counts.empty()) {
-				placed_pieces = std::max_element(piece_orientation_counts.begin(), piece_orientation_counts.end(), map_value_compare) -> second;
-			
-			}
-			possible_assignments.push(EdgeAssignment(edge, piece, placed_pieces));
+			possible_assignments[assignment_count++] = placed_pieces[edge][piece] << 8 | piece << 4 | edge;
+			std::push_heap(possible_assignments.begin(), possible_assignments.begin() + assignment_count, assignment_compare);
 		}
 	}
-	std::unordered_set<int> unassigned_edges;
-	std::unordered_set<int> unassigned_pieces;
-	for (int i = 0; i < cube.get_edge_count(); i++) {
-		unassigned_edges.insert(i);
-		unassigned_pieces.insert(i);
-	}
+
+	//bit n is set once edge or piece n is assigned
+	uint16_t assigned_edges = 0;
+	uint16_t assigned_pieces = 0;
+	const uint16_t all_edges = (1 << cube.get_edge_count()) - 1;
 	int total_pieces_placed = 0;
-	while (!unassigned_edges.empty()) {
-		auto assignment = possible_assignments.top();
-		if (unassigned_edges.count(assignment.edge) && unassigned_pieces.count(assignment.piece)) {
-			unassigned_edges.erase(assignment.edge);
-			unassigned_pieces.erase(assignment.piece);
-			total_pieces_placed += assignment.placed_pieces;
+	while (assigned_edges != all_edges) {
+		int assignment = possible_assignments[0];
+		int edge = assignment & 0xF;
+		int piece = assignment >> 4 & 0xF;
+		if (!(assigned_edges >> edge & 1) && !(assigned_pieces >> piece & 1)) {
+			assigned_edges |= 1 << edge;
+			assigned_pieces |= 1 << piece;
+			total_pieces_placed += assignment >> 8;
 		}
-		possible_assignments.pop();
+		std::pop_heap(possible_assignments.begin(), possible_assignments.begin() + assignment_count--, assignment_compare);
 	}
 	return (cube.get_edge_width()*cube.get_edge_count()) - total_pieces_placed;
 }
 
 int EdgeSolver::LastTwoEdgesHeuristic::operator()(const cube::Cube& cube) {
-	EdgeSolver solver;
-	std::unordered_set<int> top_edges = {8, 10};
-	int score = 0;
+	//edges 8 and 10 are left out of the score
+	const uint16_t scored_edges = ((1 << cube.get_edge_count()) - 1) & ~(1 << 8 | 1 << 10);
+	return __builtin_popcount(scored_edges & ~cube.get_paired_edges());
+}
+
+thread_local const EdgePatternDatabase* EdgeSolver::active_pattern_database = nullptr;
+
+int EdgeSolver::PatternDatabaseHeuristic::operator()(const cube::Cube& cube) {
+	return (*active_pattern_database)(cube, 2);
+}
+
+int EdgeSolver::OrbitHeuristic::operator()(const cube::OrbitEdges& orbit) {
+	return orbit.get_unpaired_wing_count();
+}
+
+std::vector<std::vector<int>> EdgeSolver::find_wing_orbits(const int size) {
+	cube::Cube solved(size);
+	int edge_width = solved.get_edge_width();
+	std::vector<std::vector<int>> orbits;
+	for (int slot = 0; slot < edge_width/2; slot++) {
+		std::vector<int> orbit;
+		for (int edge = 0; edge < solved.get_edge_count(); edge++) {
+			orbit.push_back(edge*edge_width + slot);
+			orbit.push_back(edge*edge_width + edge_width - 1 - slot);
+		}
+		orbits.push_back(orbit);
+	}
+
+	return orbits;
+}
+
+std::vector<uint8_t> EdgeSolver::choose_frame(const cube::Cube& cube) {
+	int edge_width = cube.get_edge_width();
+	std::vector<uint8_t> frame(cube.get_edge_count());
+	auto wing_value = [&cube](const int position) {
+		return cube.get_edge_pos(position) | cube.get_edge_orientation(position) << 7;
+	};
+	if (edge_width%2 != 0) {
+		for (int edge = 0; edge < cube.get_edge_count(); edge++) {
+			frame[edge] = wing_value(edge*edge_width + edge_width/2);
+		}
+		return frame;
+	}
+
+	//each possible assignment of a piece and orientation to an edge, with the number of the edge's wings it matches
+	std::vector<std::array<int, 4>> assignments;
 	for (int edge = 0; edge < cube.get_edge_count(); edge++) {
-		if (!top_edges.count(edge) && !solver.edge_is_solved(cube, edge)) {
-			score++;
+		std::map<int, int> matched_wings;
+		for (int i = 0; i < edge_width; i++) {
+			matched_wings[wing_value(edge*edge_width + i)]++;
+		}
+		for (int piece = 0; piece < cube.get_edge_count(); piece++) {
+			for (int orientation = 0; orientation < 2; orientation++) {
+				int value = piece | orientation << 7;
+				assignments.push_back({matched_wings.count(value) ? matched_wings[value] : 0, edge, piece, value});
+			}
+		}
+	}
+	std::stable_sort(assignments.begin(), assignments.end(), [](const std::array<int, 4>& lhs, const std::array<int, 4>& rhs) {
+		return lhs[0] > rhs[0];
+	});
+
+	std::vector<bool> assigned_edges(cube.get_edge_count());
+	std::vector<bool> assigned_pieces(cube.get_edge_count());
+	for (const auto& assignment : assignments) {
+		if (!assigned_edges[assignment[1]] && !assigned_pieces[assignment[2]]) {
+			assigned_edges[assignment[1]] = true;
+			assigned_pieces[assignment[2]] = true;
+			frame[assignment[1]] = assignment[3];
 		}
 	}
 
-	return score;
+	return frame;
+}
+
+std::vector<cube::OrbitEdges> EdgeSolver::split_orbits(const cube::Cube& cube, const std::vector<std::vector<int>>& orbit_positions,
+		const std::vector<uint8_t>& frame) {
+	using namespace cube;
+	int size = cube.get_size();
+	int edge_width = cube.get_edge_width();
+
+	//the index of each wing in its orbit
+	std::vector<int> wing_indices(edge_width*cube.get_edge_count(), -1);
+	std::vector<std::shared_ptr<OrbitEdges::OrbitTable>> tables;
+	for (const auto& positions : orbit_positions) {
+		auto table = std::make_shared<OrbitEdges::OrbitTable>();
+		table->size = size;
+		table->twist_destinations.resize(ALL_FACES.size()*size*2);
+		for (int i = 0; i < OrbitEdges::orbit_size; i++) {
+			wing_indices[positions[i]] = i;
+			table->paired_values[i] = frame[positions[i]/edge_width];
+		}
+		tables.push_back(table);
+	}
+
+	//every single layer twist is traced once for all of the orbits
+	for (const auto face : ALL_FACES) {
+		for (int layer = 0; layer < size; layer++) {
+			for (const int degrees : TwistUtils::DEGREES) {
+				auto destinations = TwistUtils::trace_wings(size, {Twist(degrees, face, layer, false)});
+				int twist_index = (static_cast<int>(face)*size + layer)*2 + (degrees == 90);
+				for (int orbit = 0; orbit < tables.size(); orbit++) {
+					auto& orbit_destinations = tables[orbit]->twist_destinations[twist_index];
+					for (int i = 0; i < OrbitEdges::orbit_size; i++) {
+						const auto& destination = destinations[orbit_positions[orbit][i]];
+						orbit_destinations[i] = wing_indices[destination.first] | destination.second << 7;
+					}
+				}
+			}
+		}
+	}
+
+	std::vector<OrbitEdges> orbits;
+	for (int orbit = 0; orbit < tables.size(); orbit++) {
+		std::array<uint8_t, OrbitEdges::orbit_size> wings;
+		for (int i = 0; i < OrbitEdges::orbit_size; i++) {
+			int position = orbit_positions[orbit][i];
+			wings[i] = cube.get_edge_pos(position) | cube.get_edge_orientation(position) << 7;
+		}
+		orbits.emplace_back(tables[orbit], wings);
+	}
+
+	return orbits;
+}
+
+bool EdgeSolver::moves_centers(const int size, const TwistSequence& twist_seq) {
+	cube::CubeCenters centers(size);
+	for (const auto& twist : twist_seq) {
+		centers.rotate(twist);
+	}
+
+	return centers.get_solved_piece_count() != centers.get_pieces_in_center()*static_cast<int>(cube::ALL_FACES.size());
 }
 
 std::vector<TwistSequence> EdgeSolver::generate_edge_commutators(const cube::Cube& cube) {
@@ -156,21 +288,12 @@ TwistSequence EdgeSolver::generate_edge_flipper(const cube::Cube& cube) {
 
 }
 
-bool EdgeSolver::edge_is_solved(const cube::Cube& cube, const int edge) {
-	int edge_start_index = edge*cube.get_edge_width();
-	int edge_pos = cube.get_edge_pos(edge_start_index);
-	int edge_orientation = cube.get_edge_orientation(edge_start_index);
-	for (int i = 1; i < cube.get_edge_width(); i++) {
-		int edge_index = edge_start_index + i;
-		if (cube.get_edge_pos(edge_index) != edge_pos || cube.get_edge_orientation(edge_index) != edge_orientation) {
-			return false;
-		}
-	}
-
-	return true;
+void EdgeSolver::log_improvement(const std::vector<cube::Twist>& twists) {
+	std::cout << "Found an edge solution of " << twists.size() << " twists\n";
+	notify_improvement(twists);
 }
 
-std::vector<cube::Twist> EdgeSolver::solve_first_ten_edges(const cube::Cube& cube) {
+search::SearchResult EdgeSolver::solve_first_ten_edges(const cube::Cube& cube) {
 	using namespace cube;
 	std::array<Face, 3> axis_faces = {Face::LEFT, Face::BOTTOM, Face::BACK};
 	
@@ -182,24 +305,32 @@ std::vector<cube::Twist> EdgeSolver::solve_first_ten_edges(const cube::Cube& cub
 	auto cube_rotations = TwistUtils::generate_cube_rotations(cube);
 	twist_sequences.insert(twist_sequences.end(), cube_rotations.begin(), cube_rotations.end());
 	
-	auto is_finished = [this](const cube::Cube& cube) {
-		int unsolved_edges = 0;
-		for (int i = 0; i < cube.get_edge_count(); i++) {
-			if (!this->edge_is_solved(cube, i)) {
-				unsolved_edges++;
-				if (unsolved_edges > 2) {
-					return false;	
-				}
-			}
-		}
-
-		return true;
+	auto is_finished = [](const cube::Cube& cube) {
+		const uint16_t all_edges = (1 << cube.get_edge_count()) - 1;
+		return __builtin_popcount(all_edges & ~cube.get_paired_edges()) <= 2;
 	};
-	
-	return search::best_first_search<cube::Cube, EdgeHeuristic>(cube, twist_sequences, is_finished);
+
+	//the patterns only cover every wing of a piece when the wings form a single group. On bigger cubes, each
+	//group is estimated on its own, which guides the search worse than EdgeHeuristic, so it is used instead
+	if (settings.use_pattern_databases && cube.get_edge_width() <= 3) {
+		if (first_ten_edges_database == nullptr) {
+			first_ten_edges_database = std::make_unique<EdgePatternDatabase>(
+					settings.pattern_database_dir/("edges_" + std::to_string(cube.get_size()) + ".pdb"), 
+					cube.get_size(), twist_sequences, settings.pattern_combination);
+		}
+		active_pattern_database = first_ten_edges_database.get();
+		auto result = search::anytime_weighted_a_star_search<cube::Cube, PatternDatabaseHeuristic>(cube, twist_sequences, is_finished, 
+				settings.refinement_budget, limits, [this](const std::vector<cube::Twist>& twists) {log_improvement(twists);},
+				settings.partial_expansion);
+		active_pattern_database = nullptr;
+		return result;
+	}
+	return search::anytime_weighted_a_star_search<cube::Cube, EdgeHeuristic>(cube, twist_sequences, is_finished, 
+			settings.refinement_budget, limits, [this](const std::vector<cube::Twist>& twists) {log_improvement(twists);},
+			settings.partial_expansion);
 }
 
-std::vector<cube::Twist> EdgeSolver::solve_last_two_edges(const cube::Cube& cube) {
+search::SearchResult EdgeSolver::solve_last_two_edges(const cube::Cube& cube) {
 	using namespace cube;
 	auto twist_sequences = generate_edge_commutators(cube);
 	if (cube.get_size()%2 != 0) {
@@ -214,29 +345,104 @@ std::vector<cube::Twist> EdgeSolver::solve_last_two_edges(const cube::Cube& cube
 		Twist(90, Face::TOP),
 	});
 
-	auto is_finished = [this](const cube::Cube& cube) {
-		for (int edge = 0; edge < cube.get_edge_count(); edge++) {
-			if (!this->edge_is_solved(cube, edge)) {
-				return false;	
+	auto is_finished = [](const cube::Cube& cube) {
+		return cube.get_paired_edges() == (1 << cube.get_edge_count()) - 1;
+	};
+	
+	return search::anytime_weighted_a_star_search<cube::Cube, LastTwoEdgesHeuristic>(cube, twist_sequences, is_finished, 
+			settings.refinement_budget, limits, [this](const std::vector<cube::Twist>& twists) {log_improvement(twists);},
+			settings.partial_expansion);
+}
+
+search::SearchStatus EdgeSolver::solve_orbits(const cube::Cube& cube) {
+	auto orbit_positions = find_wing_orbits(cube.get_size());
+	auto orbits = split_orbits(cube, orbit_positions, choose_frame(cube));
+
+	//the wing swaps of each orbit are the commutators that move none of the corners, the centers or the wings of
+	//other orbits
+	std::vector<std::vector<TwistSequence>> orbit_swaps(orbits.size());
+	std::vector<int> wing_orbits(cube.get_edge_width()*cube.get_edge_count(), -1);
+	for (int orbit = 0; orbit < orbit_positions.size(); orbit++) {
+		for (const int position : orbit_positions[orbit]) {
+			wing_orbits[position] = orbit;
+		}
+	}
+	for (const auto& commutator : generate_edge_commutators(cube)) {
+		cube::Cube moved(cube.get_size());
+		for (const auto& twist : commutator) {
+			moved.rotate(twist);
+		}
+		bool moves_corners = false;
+		for (int corner = 0; corner < moved.get_corner_count(); corner++) {
+			moves_corners = moves_corners || moved.get_corner_pos(corner) != corner || moved.get_corner_orientation(corner) != 0;
+		}
+		std::vector<int> moved_orbits;
+		auto destinations = TwistUtils::trace_wings(cube.get_size(), commutator);
+		for (int position = 0; position < destinations.size(); position++) {
+			if (destinations[position].first != position || destinations[position].second) {
+				moved_orbits.push_back(wing_orbits[position]);
 			}
 		}
+		if (!moves_corners && !moved_orbits.empty() && moved_orbits.front() != -1 &&
+				std::count(moved_orbits.begin(), moved_orbits.end(), moved_orbits.front()) == moved_orbits.size() &&
+				!moves_centers(cube.get_size(), commutator)) {
+			orbit_swaps[moved_orbits.front()].push_back(commutator);
+		}
+	}
+	for (int orbit = 0; orbit < orbits.size(); orbit++) {
+		if (orbit_swaps[orbit].empty()) {
+			throw std::invalid_argument("No commutator swaps the wings of orbit " + std::to_string(orbit) + " alone");
+		}
+	}
 
-		return true;
+	//a swap that moves center pieces within their faces can move them to other faces when it's set up
+	//with slices, and the centers are solved before the edges
+	auto generate_moves = [&](const int orbit) {
+		return search::generate_orbit_moves(orbits[orbit], orbit_swaps[orbit], settings.orbit_setup_depth, [&](const TwistSequence& move) {
+			return !moves_centers(cube.get_size(), move);
+		});
 	};
-	
-	return search::best_first_search<cube::Cube, LastTwoEdgesHeuristic>(cube, twist_sequences, is_finished);
+	auto is_finished = [](const cube::OrbitEdges& orbit) {
+		return orbit.get_unpaired_wing_count() == 0;
+	};
+	int threads = settings.orbit_threads > 0 ? settings.orbit_threads : std::thread::hardware_concurrency();
+	int worker_count = std::max(1, std::min<int>(threads, orbits.size()));
+	std::cout << "Pairing " << orbits.size() << " wing orbits on " << worker_count << " threads\n";
+	auto result = search::orbit_search<cube::OrbitEdges, OrbitHeuristic>(orbits, generate_moves, is_finished, worker_count, limits,
+			settings.partial_expansion);
+	notify_listeners(result.twists);
+	if (!result.solved()) {
+		std::cout << "Edge search stopped: " << result.status << "\n";
+		return result.status;
+	}
+
+	std::cout << "All edges solved!\n";
+	return search::SearchStatus::SOLVED;
 }
 
-void EdgeSolver::solve(const cube::Cube& cube) {
+search::SearchStatus EdgeSolver::solve(const cube::Cube& cube) {
+	if (settings.orbit_parallel) {
+		return solve_orbits(cube);
+	}
 	cube::Cube current_state(cube);
 
 	std::cout << "Solving the first 10 edges\n";
-	auto partial_solution = solve_first_ten_edges(current_state);
-	for (const auto& twist : partial_solution) {
+	auto partial_solution = settings.constructive ? EdgePlanner(cube.get_size()).solve(current_state, limits) : solve_first_ten_edges(current_state);
+	for (const auto& twist : partial_solution.twists) {
 		current_state.rotate(twist);
 	}
-	notify_listeners(partial_solution);
+	notify_listeners(partial_solution.twists);
+	if (!partial_solution.solved()) {
+		std::cout << "Edge search stopped: " << partial_solution.status << "\n";
+		return partial_solution.status;
+	}
 	std::cout << "First 10 edges solved. Solving the last 2 edges\n";
-	notify_listeners(solve_last_two_edges(current_state));
+	auto final_solution = solve_last_two_edges(current_state);
+	notify_listeners(final_solution.twists);
+	if (!final_solution.solved()) {
+		std::cout << "Edge search stopped: " << final_solution.status << "\n";
+		return final_solution.status;
+	}
 	std::cout << "All edges solved!\n";
+	return search::SearchStatus::SOLVED;
 }
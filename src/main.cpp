@@ -14,10 +14,11 @@ void start_ui(const std::vector<int>& cube_sizes) {
 		solve_threads.emplace_back(&ui::MultiCubeUI::solve_cube, &ui, i);
 	}
 	ui.getRoot() -> startRendering();
-	ui.closeApp();
+	ui.cancel_solves();
 	for (auto& th : solve_threads) {
 		th.join();
 	}
+	ui.closeApp();
 
 }
 
@@ -0,0 +1,66 @@
+#include "move_pruning.h"
+#include "twist_utils.h"
+#include <algorithm>
+
+using namespace ai;
+
+MovePruningTable::MovePruningTable(const std::vector<TwistSequence>& twist_sequences, const int cube_size) :
+	sequence_count(twist_sequences.size()),
+	redundant(twist_sequences.size()*twist_sequences.size(), false) {
+
+	std::vector<std::vector<AxisTwist>> axis_sequences;
+	for (const auto& twist_seq : twist_sequences) {
+		std::vector<AxisTwist> axis_sequence;
+		for (const auto& twist : twist_seq) {
+			axis_sequence.push_back(to_axis_twist(twist, cube_size));
+		}
+		axis_sequences.push_back(axis_sequence);
+	}
+	for (int last = 0; last < sequence_count; last++) {
+		for (int next = 0; next < sequence_count; next++) {
+			redundant[last*sequence_count + next] = is_inverse(axis_sequences[last], axis_sequences[next]) ||
+				(next < last && commutes(axis_sequences[last], axis_sequences[next]));
+		}
+	}
+}
+
+MovePruningTable::AxisTwist MovePruningTable::to_axis_twist(const cube::Twist& twist, const int cube_size) {
+	//a twist of a layer is the same as the opposite twist of the layer counted from the opposing face
+	auto& axis_faces = TwistUtils::AXIS_FACES;
+	bool axis_face = std::find(axis_faces.begin(), axis_faces.end(), twist.face) != axis_faces.end();
+	AxisTwist axis_twist;
+	axis_twist.axis = axis_face ? twist.face : cube::OPPOSING_FACES.at(twist.face);
+	axis_twist.degrees = axis_face ? twist.degrees : -twist.degrees;
+	axis_twist.layers = 0;
+	for (int layer = twist.layer; layer >= (twist.wide_turn ? 0 : twist.layer); layer--) {
+		axis_twist.layers |= uint64_t(1) << (axis_face ? layer : cube_size-1-layer);
+	}
+
+	return axis_twist;
+}
+
+bool MovePruningTable::is_inverse(const std::vector<AxisTwist>& last, const std::vector<AxisTwist>& next) {
+	if (last.size() != next.size() || last.empty()) {
+		return false;
+	}
+	for (int i = 0; i < next.size(); i++) {
+		const auto& undone = last[last.size()-1-i];
+		if (next[i].axis != undone.axis || next[i].layers != undone.layers || next[i].degrees != -undone.degrees) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool MovePruningTable::commutes(const std::vector<AxisTwist>& last, const std::vector<AxisTwist>& next) {
+	if (last.empty() || next.empty()) {
+		return false;
+	}
+	cube::Face axis = last[0].axis;
+	auto on_axis = [axis](const AxisTwist& twist) {
+		return twist.axis == axis;
+	};
+
+	return std::all_of(last.begin(), last.end(), on_axis) && std::all_of(next.begin(), next.end(), on_axis);
+}
@@ -3,6 +3,7 @@
 #include "scramble_generator.h"
 #include "cube_solver.h"
 #include <iostream>
+#include <algorithm>
 
 using namespace ui;
 
@@ -17,7 +18,7 @@ void MultiCubeUI::SolutionExecutor::start_solution() {
 	}
 }
 
-MultiCubeUI::MultiCubeUI(const std::vector<int>& cube_sizes) {
+MultiCubeUI::MultiCubeUI(const std::vector<int>& cube_sizes) : solve_cancellation(false) {
 	for (const int size : cube_sizes) {
 		sym_cubes.push_back(cube::CombinedCube(size));
 	}
@@ -59,11 +60,33 @@ bool MultiCubeUI::keyPressed(const OgreBites::KeyboardEvent& event) {
 
 void MultiCubeUI::solve_cube(const int cube_index) {
 	auto exec_ptr = std::make_unique<SolutionExecutor>(cube_displays[cube_index].get());
-	ai::CubeSolver solver;
+	//cores not needed by the other solver threads race differently configured solvers: the default 
+	//configuration, one that goes straight to the commutator based center search, and one that
+	//is more patient with the first center strategy and stores fewer edge states
+	std::vector<ai::PortfolioEntry> portfolio(3);
+	portfolio[1].center_settings.begin_with_strategy_1 = false;
+	portfolio[2].center_settings.strategy_1_patience = 10;
+	portfolio[2].edge_settings.partial_expansion = true;
+	std::size_t spare_cores = std::thread::hardware_concurrency()/sym_cubes.size();
+	portfolio.resize(std::max<std::size_t>(1, std::min(spare_cores, portfolio.size())));
+	//the orbit searches of an entry run on its share of the spare cores
+	int orbit_threads = std::max<std::size_t>(1, spare_cores/portfolio.size());
+	for (auto& entry : portfolio) {
+		entry.center_settings.orbit_threads = orbit_threads;
+		entry.edge_settings.orbit_threads = orbit_threads;
+	}
+
+	ai::search::SearchLimits limits;
+	limits.max_memory = search_memory_limit/portfolio.size();
+	limits.cancellation_token = &solve_cancellation;
+	ai::CubeSolver solver(limits, portfolio);
 	solver.add_twist_listener(exec_ptr.get());
 	{
 		std::unique_lock<std::mutex>(executor_mex);
 		executors.push_back(std::move(exec_ptr));
 	}
-	solver.solve(sym_cubes[cube_index]);
+	auto status = solver.solve(sym_cubes[cube_index]);
+	if (status != ai::search::SearchStatus::SOLVED) {
+		std::cout << "Solving cube " << cube_index << " stopped: " << status << "\n";
+	}
 }
@@ -0,0 +1,43 @@
+#include "orbit_centers.h"
+#include "twist.h"
+
+using namespace cube;
+
+constexpr int OrbitCenters::orbit_size;
+
+int OrbitCenters::get_unsolved_piece_count() const {
+	int unsolved_pieces = 0;
+	for (int i = 0; i < orbit_size; i++) {
+		unsolved_pieces += pieces[i] != table->solved_values[i];
+	}
+
+	return unsolved_pieces;
+}
+
+int OrbitCenters::get_opposed_piece_count() const {
+	int opposed_pieces = 0;
+	for (int i = 0; i < orbit_size; i++) {
+		opposed_pieces += pieces[i] == table->opposed_values[i];
+	}
+
+	return opposed_pieces;
+}
+
+void OrbitCenters::rotate(const Twist& twist) {
+	for (int layer = twist.layer; layer >= (twist.wide_turn ? 0 : twist.layer); layer--) {
+		const auto& destinations = table->twist_destinations[(static_cast<int>(twist.face)*table->size + layer)*2 + (twist.degrees == 90)];
+		std::array<uint8_t, orbit_size> moved_pieces;
+		for (int i = 0; i < orbit_size; i++) {
+			moved_pieces[destinations[i]] = pieces[i];
+		}
+		pieces = moved_pieces;
+	}
+}
+
+void OrbitCenters::write(std::ostream& stream) const {
+	stream.write(reinterpret_cast<const char*>(pieces.data()), orbit_size);
+}
+
+void OrbitCenters::read(std::istream& stream) {
+	stream.read(reinterpret_cast<char*>(pieces.data()), orbit_size);
+}
@@ -0,0 +1,35 @@
+#include "orbit_edges.h"
+#include "twist.h"
+
+using namespace cube;
+
+constexpr int OrbitEdges::orbit_size;
+
+int OrbitEdges::get_unpaired_wing_count() const {
+	int unpaired_wings = 0;
+	for (int i = 0; i < orbit_size; i++) {
+		unpaired_wings += wings[i] != table->paired_values[i];
+	}
+
+	return unpaired_wings;
+}
+
+void OrbitEdges::rotate(const Twist& twist) {
+	for (int layer = twist.layer; layer >= (twist.wide_turn ? 0 : twist.layer); layer--) {
+		const auto& destinations = table->twist_destinations[(static_cast<int>(twist.face)*table->size + layer)*2 + (twist.degrees == 90)];
+		std::array<uint8_t, orbit_size> moved_wings;
+		for (int i = 0; i < orbit_size; i++) {
+			//the flip bit of the destination is the orientation bit of the wing
+			moved_wings[destinations[i] & 0x7F] = wings[i] ^ (destinations[i] & 0x80);
+		}
+		wings = moved_wings;
+	}
+}
+
+void OrbitEdges::write(std::ostream& stream) const {
+	stream.write(reinterpret_cast<const char*>(wings.data()), orbit_size);
+}
+
+void OrbitEdges::read(std::istream& stream) {
+	stream.read(reinterpret_cast<char*>(wings.data()), orbit_size);
+}
@@ -0,0 +1,25 @@
+#include "search_limits.h"
+
+using namespace ai;
+
+std::ostream& search::operator<<(std::ostream& stream, const search::SearchStatus& status) {
+	switch (status) {
+		case search::SearchStatus::SOLVED:
+			stream << "solved";
+			break;
+		case search::SearchStatus::CANCELLED:
+			stream << "cancelled";
+			break;
+		case search::SearchStatus::TIMED_OUT:
+			stream << "timed out";
+			break;
+		case search::SearchStatus::EXPANSION_LIMIT_REACHED:
+			stream << "expansion limit reached";
+			break;
+		case search::SearchStatus::MEMORY_LIMIT_REACHED:
+			stream << "memory limit reached";
+			break;
+	};
+
+	return stream;
+}
@@ -0,0 +1,323 @@
+#include "stage_table.h"
+#include "checkpoint.h"
+#include "twist.h"
+#include <boost/functional/hash.hpp>
+#include <boost/crc.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace ai;
+using namespace search;
+
+constexpr uint32_t StageTable::magic;
+constexpr uint32_t StageTable::version;
+constexpr uint32_t StageTable::state_bits;
+constexpr uint32_t StageTable::block_length;
+constexpr std::size_t StageTable::header_length;
+constexpr int StageTable::unreached;
+
+namespace {
+	uint32_t checksum(const uint8_t* data, const std::size_t length) {
+		boost::crc_32_type crc;
+		crc.process_bytes(data, length);
+
+		return crc.checksum();
+	}
+
+	std::string compress(const uint8_t* data, const std::size_t length) {
+		std::string compressed;
+		{
+			boost::iostreams::filtering_ostream stream;
+			stream.push(boost::iostreams::zlib_compressor());
+			stream.push(boost::iostreams::back_inserter(compressed));
+			stream.write(reinterpret_cast<const char*>(data), length);
+			stream.reset();
+		}
+
+		return compressed;
+	}
+
+	//decompresses data compressed by compress into 'destination', which must have room for exactly 'length'
+	//bytes. Returns false if the data is corrupt or decompresses to another length
+	bool decompress(const char* data, const std::size_t compressed_length, uint8_t* destination, const std::size_t length) {
+		try {
+			boost::iostreams::filtering_istream stream;
+			stream.push(boost::iostreams::zlib_decompressor());
+			stream.push(boost::iostreams::array_source(data, compressed_length));
+			stream.read(reinterpret_cast<char*>(destination), length);
+			return stream.gcount() == length && stream.get() == std::char_traits<char>::eof();
+		}
+		catch (const boost::iostreams::zlib_error&) {
+			return false;
+		}
+	}
+}
+
+std::vector<uint32_t> StageTable::generate_move_table(const Coordinate& coordinate) const {
+	std::vector<uint32_t> move_table(coordinate.count*moves.size());
+	for (int value = 0; value < coordinate.count; value++) {
+		auto cube = coordinate.set(value);
+		for (int move = 0; move < moves.size(); move++) {
+			cube::Cube child(cube);
+			for (const auto& twist : moves[move]) {
+				child.rotate(twist);
+			}
+			move_table[value*moves.size() + move] = coordinate.get(child);
+		}
+	}
+
+	return move_table;
+}
+
+uint64_t StageTable::get_state(const cube::Cube& cube) const {
+	uint64_t state = 0;
+	for (const auto& coordinate : coordinates) {
+		state = state*coordinate.count + coordinate.get(cube);
+	}
+
+	return state;
+}
+
+void StageTable::find_children(const uint64_t state, std::vector<uint64_t>& children) const {
+	std::fill(children.begin(), children.end(), 0);
+	for (int i = 0; i < coordinates.size(); i++) {
+		const auto* moved_values = &move_tables[i][(state/places[i])%coordinates[i].count*moves.size()];
+		for (int move = 0; move < moves.size(); move++) {
+			children[move] += moved_values[move]*places[i];
+		}
+	}
+}
+
+void StageTable::generate(const boost::filesystem::path& file_path, const uint64_t key) const {
+	//layers are split between workers once they are long enough to be worth it
+	constexpr std::size_t min_part_length = 4096;
+
+	//every state starts unreached, with both of its bits set. The bytes are atomic, since workers expanding
+	//the same layer can reach states sharing a byte
+	std::size_t table_length = (state_count+3)/4;
+	std::unique_ptr<std::atomic<uint8_t>[]> atomic_table(new std::atomic<uint8_t>[table_length]);
+	for (std::size_t i = 0; i < table_length; i++) {
+		atomic_table[i].store(0xFF, std::memory_order_relaxed);
+	}
+
+	//sets the distance of the given state if it is unreached. Returns false if it was already reached
+	auto reach = [&atomic_table](const uint64_t state, const int distance) {
+		auto& byte = atomic_table[state/4];
+		int shift = state%4*2;
+		uint8_t value = byte.load(std::memory_order_relaxed);
+		do {
+			if (((value >> shift) & 3) != unreached) {
+				return false;
+			}
+		} while (!byte.compare_exchange_weak(value, (value & ~(3 << shift)) | (distance << shift), std::memory_order_relaxed));
+
+		return true;
+	};
+
+	//the moves of a stage include their inverses, so the distance from a state to the solved state is the same as
+	//the distance the other way. Each worker expands a contiguous part of the layer into its own part of the next
+	//layer, and the parts are joined in order once every worker is done
+	int worker_count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	std::vector<uint64_t> layer = {solved_state};
+	reach(solved_state, 0);
+	for (int depth = 1; !layer.empty(); depth++) {
+		std::size_t part_count = std::max<std::size_t>(1, std::min<std::size_t>(worker_count, layer.size()/min_part_length));
+		std::vector<std::vector<uint64_t>> next_parts(part_count);
+		auto expand = [this, &layer, &next_parts, &reach, part_count, depth](const std::size_t part) {
+			std::vector<uint64_t> children(moves.size());
+			for (std::size_t i = layer.size()*part/part_count; i < layer.size()*(part+1)/part_count; i++) {
+				find_children(layer[i], children);
+				for (const auto child : children) {
+					if (reach(child, depth%3)) {
+						next_parts[part].push_back(child);
+					}
+				}
+			}
+		};
+		std::vector<std::thread> workers;
+		for (std::size_t part = 1; part < part_count; part++) {
+			workers.emplace_back(expand, part);
+		}
+		expand(0);
+		for (auto& worker : workers) {
+			worker.join();
+		}
+
+		layer.clear();
+		for (const auto& part : next_parts) {
+			layer.insert(layer.end(), part.begin(), part.end());
+		}
+	}
+
+	std::vector<uint8_t> table(table_length);
+	for (std::size_t i = 0; i < table_length; i++) {
+		table[i] = atomic_table[i].load(std::memory_order_relaxed);
+	}
+
+	checkpoint::save(file_path, [&](std::ostream& file) {
+		checkpoint::write_value(file, magic);
+		checkpoint::write_value(file, version);
+		checkpoint::write_value<uint32_t>(file, stage);
+		checkpoint::write_value(file, state_bits);
+		checkpoint::write_value(file, key);
+		checkpoint::write_value(file, state_count);
+		checkpoint::write_value<uint32_t>(file, compressed ? block_length : 0);
+		checkpoint::write_value(file, checksum(table.data(), table.size()));
+		if (compressed) {
+			std::vector<std::string> blocks;
+			std::vector<uint64_t> offsets = {0};
+			for (std::size_t start = 0; start < table.size(); start += block_length) {
+				blocks.push_back(compress(table.data() + start, std::min<std::size_t>(block_length, table.size() - start)));
+				offsets.push_back(offsets.back() + blocks.back().size());
+			}
+			for (const auto offset : offsets) {
+				checkpoint::write_value(file, offset);
+			}
+			for (const auto& block : blocks) {
+				file.write(block.data(), block.size());
+			}
+		}
+		else {
+			file.write(reinterpret_cast<const char*>(table.data()), table.size());
+		}
+	});
+}
+
+bool StageTable::load(const boost::filesystem::path& file_path, const uint64_t key) {
+	if (!boost::filesystem::exists(file_path)) {
+		return false;
+	}
+	FileHeader header;
+	{
+		std::ifstream stream(file_path.string(), std::ifstream::binary);
+		try {
+			header.magic = checkpoint::read_value<uint32_t>(stream);
+			header.version = checkpoint::read_value<uint32_t>(stream);
+			header.stage = checkpoint::read_value<uint32_t>(stream);
+			header.state_bits = checkpoint::read_value<uint32_t>(stream);
+			header.key = checkpoint::read_value<uint64_t>(stream);
+			header.state_count = checkpoint::read_value<uint64_t>(stream);
+			header.block_length = checkpoint::read_value<uint32_t>(stream);
+			header.checksum = checkpoint::read_value<uint32_t>(stream);
+		}
+		catch (const std::runtime_error&) {
+			return false;
+		}
+	}
+	if (header.magic != magic || header.version != version || header.stage != stage || header.state_bits != state_bits ||
+			header.key != key || header.state_count != state_count) {
+		return false;
+	}
+
+	if (file.is_open()) {
+		file.close();
+	}
+	file.open(file_path.string());
+	std::size_t table_length = (state_count+3)/4;
+	const char* data = file.data() + header_length;
+	std::size_t data_length = file.size() - header_length;
+	if (header.block_length == 0) {
+		if (data_length != table_length) {
+			return false;
+		}
+		std::vector<uint8_t>().swap(decompressed_table);
+		distances = reinterpret_cast<const uint8_t*>(data);
+	}
+	else {
+		std::size_t block_count = (table_length + header.block_length - 1)/header.block_length;
+		std::size_t offsets_length = (block_count+1)*sizeof(uint64_t);
+		if (data_length < offsets_length) {
+			return false;
+		}
+		std::vector<uint64_t> offsets(block_count+1);
+		std::copy(data, data + offsets_length, reinterpret_cast<char*>(offsets.data()));
+		if (offsets.front() != 0 || offsets.back() != data_length - offsets_length || !std::is_sorted(offsets.begin(), offsets.end())) {
+			return false;
+		}
+
+		decompressed_table.resize(table_length);
+		for (std::size_t block = 0; block < block_count; block++) {
+			std::size_t start = block*header.block_length;
+			if (!decompress(data + offsets_length + offsets[block], offsets[block+1] - offsets[block], decompressed_table.data() + start,
+						std::min<std::size_t>(header.block_length, table_length - start))) {
+				return false;
+			}
+		}
+		file.close();
+		distances = decompressed_table.data();
+	}
+
+	return checksum(distances, table_length) == header.checksum;
+}
+
+StageTable::StageTable(const boost::filesystem::path& file_path, const int stage, const std::vector<Coordinate>& coordinates,
+		const std::vector<TwistSequence>& moves, const bool compressed) :
+	stage(stage), compressed(compressed), coordinates(coordinates), moves(moves), state_count(1) {
+	for (const auto& coordinate : coordinates) {
+		move_tables.push_back(generate_move_table(coordinate));
+	}
+	places.resize(coordinates.size());
+	for (int i = coordinates.size()-1; i >= 0; i--) {
+		places[i] = state_count;
+		state_count *= coordinates[i].count;
+	}
+	solved_state = get_state(cube::Cube(3));
+
+	uint64_t key = checkpoint::hash_twist_sequences(moves);
+	for (const auto& coordinate : coordinates) {
+		boost::hash_combine(key, coordinate.count);
+	}
+
+	//other threads or processes may load the same table, which is only generated once. Tables that are stale or
+	//corrupt are generated again rather than used
+	checkpoint::FileLock lock(file_path);
+	if (!load(file_path, key)) {
+		std::cout << "Generating the stage table " << file_path.string() << "\n";
+		generate(file_path, key);
+		if (!load(file_path, key)) {
+			throw std::runtime_error("Couldn't read stage table " + file_path.string());
+		}
+		std::cout << "Stage table generated\n";
+	}
+}
+
+TwistSequence StageTable::solve(const cube::Cube& cube) const {
+	TwistSequence solution;
+	uint64_t state = get_state(cube);
+	int distance = get_distance(state);
+	if (distance == unreached) {
+		throw std::runtime_error("The cube can't be solved with the moves of the stage");
+	}
+
+	//the distances of the children are prefetched together, since each one is usually in a different cache line,
+	//and the first child one move closer is picked without branching on the distances
+	std::vector<uint64_t> children(moves.size());
+	while (state != solved_state) {
+		find_children(state, children);
+		for (const auto child : children) {
+			__builtin_prefetch(distances + child/4);
+		}
+		int next_distance = (distance+2)%3;
+		int next_move = moves.size();
+		for (int move = moves.size()-1; move >= 0; move--) {
+			next_move = get_distance(children[move]) == next_distance ? move : next_move;
+		}
+		if (next_move == moves.size()) {
+			throw std::runtime_error("No move of the stage brings the cube closer to being solved");
+		}
+		solution.insert(solution.end(), moves[next_move].begin(), moves[next_move].end());
+		state = children[next_move];
+		distance = next_distance;
+	}
+
+	return solution;
+}
@@ -0,0 +1,29 @@
+#include "stage_table_registry.h"
+
+using namespace ai;
+
+StageTableRegistry& StageTableRegistry::get_instance() {
+	static StageTableRegistry registry;
+
+	return registry;
+}
+
+std::shared_ptr<const StageTable> StageTableRegistry::get_table(const boost::filesystem::path& file_path,
+		const std::function<std::unique_ptr<StageTable>()>& create_table) {
+	std::shared_ptr<Entry> entry;
+	{
+		std::lock_guard<std::mutex> lock(entries_mutex);
+		auto& stored_entry = entries[boost::filesystem::absolute(file_path).lexically_normal().string()];
+		if (!stored_entry) {
+			stored_entry = std::make_shared<Entry>();
+		}
+		entry = stored_entry;
+	}
+
+	//if loading the table throws, the flag is left unset and the next request tries again
+	std::call_once(entry->loaded, [&entry, &create_table]() {
+		entry->table = create_table();
+	});
+
+	return entry->table;
+}
@@ -1,4 +1,5 @@
 #include "three_cube_solver.h"
+#include "stage_table_registry.h"
 #include "cube.h"
 #include "cube_centers.h"
 #include "combined_cube.h"
@@ -6,46 +7,285 @@
 #include "twist_utils.h"
 #include "search.h"
 #include "hash.h"
-#include <queue>
-#include <cmath>
 #include <algorithm>
 #include <iostream>
+#include <sstream>
+#include <memory>
+#include <thread>
+#include <exception>
 
 using namespace ai;
 
-ThreeCubeSolver::ThreeCubeSolver() : twist_mappings(create_twist_mappings()), table_dir("tables") {
-	using namespace cube;
-	std::array<std::unordered_set<cube::Face>, stage_count> restricted_faces = {{
-		{},
-		{Face::TOP, Face::BOTTOM},	
-		{Face::TOP, Face::BOTTOM, Face::FRONT, Face::BACK},
-		{Face::TOP, Face::BOTTOM, Face::FRONT, Face::BACK, Face::LEFT, Face::RIGHT},
-	}};
-	if (!boost::filesystem::exists(table_dir)) {
-		boost::filesystem::create_directory(table_dir);
+namespace {
+	int choose(const int n, const int k) {
+		if (k < 0 || k > n) {
+			return 0;
+		}
+		int result = 1;
+		for (int i = 1; i <= k; i++) {
+			result = result*(n-k+i)/i;
+		}
+
+		return result;
 	}
-	for (int stage = 0; stage < stage_count; stage++) {
-		auto file_path = table_dir/filenames[stage];
-		if (!boost::filesystem::exists(file_path)) {
-			std::cout << "Generating table for stage " << stage << ". This may take some time."  << "\n";
-			save_lookup_table(create_lookup_table(encoders[stage], generate_twist_sequences(restricted_faces[stage])), file_path.string());
-			std::cout << "Table for stage " << stage << " generated\n";
+
+	//returns the rank of the chosen elements among every way of choosing as many of the elements, in the
+	//combinatorial number system
+	int rank_combination(const std::vector<bool>& chosen) {
+		int rank = 0;
+		int chosen_count = 0;
+		for (int i = 0; i < chosen.size(); i++) {
+			if (chosen[i]) {
+				chosen_count++;
+				rank += choose(i, chosen_count);
+			}
 		}
+
+		return rank;
 	}
-}
 
-ThreeCubeSolver::TwistEncodingMap ThreeCubeSolver::create_twist_mappings() {
-		TwistEncodingMap twist_mappings;
-		char encoding = 0;
-		for (const auto face : cube::ALL_FACES) {
-			for (const int degrees : TwistUtils::DEGREES) {
-				encoding++;
-				twist_mappings.insert(TwistEncodingMap::value_type(cube::Twist(degrees, face), encoding));
+	//returns the way of choosing 'k' of 'n' elements with the given rank
+	std::vector<bool> unrank_combination(int rank, const int n, int k) {
+		std::vector<bool> chosen(n);
+		for (int i = n-1; i >= 0 && k > 0; i--) {
+			if (choose(i, k) <= rank) {
+				chosen[i] = true;
+				rank -= choose(i, k);
+				k--;
 			}
 		}
 
-		return twist_mappings;
+		return chosen;
+	}
+
+	//returns the rank of a permutation of the integers below its size, from its Lehmer code
+	int rank_permutation(const std::vector<int>& permutation) {
+		int rank = 0;
+		for (int i = 0; i < permutation.size(); i++) {
+			int smaller_after = 0;
+			for (int j = i+1; j < permutation.size(); j++) {
+				smaller_after += permutation[j] < permutation[i];
+			}
+			rank = rank*(permutation.size()-i) + smaller_after;
+		}
+
+		return rank;
+	}
 
+	//returns the permutation of the integers below 'n' with the given rank
+	std::vector<int> unrank_permutation(int rank, const int n) {
+		std::vector<int> lehmer_code(n);
+		for (int i = n-1; i >= 0; i--) {
+			lehmer_code[i] = rank%(n-i);
+			rank /= n-i;
+		}
+		std::vector<int> unused(n);
+		for (int i = 0; i < n; i++) {
+			unused[i] = i;
+		}
+		std::vector<int> permutation;
+		for (const int smaller_after : lehmer_code) {
+			permutation.push_back(unused[smaller_after]);
+			unused.erase(unused.begin() + smaller_after);
+		}
+
+		return permutation;
+	}
+
+	//returns a 3x3 cube with the given pieces, encoded like the pieces of a Cube
+	cube::Cube create_cube(const std::array<uint8_t, 12>& edges, const std::array<uint8_t, 8>& corners) {
+		std::stringstream stream;
+		stream.write(reinterpret_cast<const char*>(edges.data()), edges.size());
+		stream.write(reinterpret_cast<const char*>(corners.data()), corners.size());
+		cube::Cube cube(3);
+		cube.read(stream);
+
+		return cube;
+	}
+
+	std::array<uint8_t, 12> solved_edges() {
+		std::array<uint8_t, 12> edges;
+		for (int i = 0; i < edges.size(); i++) {
+			edges[i] = i;
+		}
+
+		return edges;
+	}
+
+	std::array<uint8_t, 8> solved_corners() {
+		std::array<uint8_t, 8> corners;
+		for (int i = 0; i < corners.size(); i++) {
+			corners[i] = i;
+		}
+
+		return corners;
+	}
+
+	//returns the positions of the edges or corners that the given twist sequences move between each other,
+	//in increasing order
+	std::vector<std::vector<int>> find_orbits(const std::vector<TwistSequence>& twist_sequences, const bool corners) {
+		int piece_count = corners ? 8 : 12;
+		std::vector<int> orbit_ids(piece_count);
+		for (int i = 0; i < piece_count; i++) {
+			orbit_ids[i] = i;
+		}
+		for (const auto& twist_seq : twist_sequences) {
+			cube::Cube cube(3);
+			for (const auto& twist : twist_seq) {
+				cube.rotate(twist);
+			}
+			for (int position = 0; position < piece_count; position++) {
+				int merged_id = orbit_ids[corners ? cube.get_corner_pos(position) : cube.get_edge_pos(position)];
+				int kept_id = orbit_ids[position];
+				std::replace(orbit_ids.begin(), orbit_ids.end(), merged_id, kept_id);
+			}
+		}
+
+		std::vector<std::vector<int>> orbits;
+		for (int id = 0; id < piece_count; id++) {
+			std::vector<int> orbit;
+			for (int position = 0; position < piece_count; position++) {
+				if (orbit_ids[position] == id) {
+					orbit.push_back(position);
+				}
+			}
+			if (!orbit.empty()) {
+				orbits.push_back(orbit);
+			}
+		}
+
+		return orbits;
+	}
+
+	//returns the coordinate of the permutations of the edges or corners within the given orbits. Pieces
+	//must be in the orbits of their solved positions
+	Coordinate create_orbit_permutation_coordinate(const std::vector<std::vector<int>>& orbits, const bool corners) {
+		Coordinate coordinate;
+		coordinate.count = 1;
+		for (const auto& orbit : orbits) {
+			for (int i = 2; i <= orbit.size(); i++) {
+				coordinate.count *= i;
+			}
+		}
+		auto get_piece = [corners](const cube::Cube& cube, const int position) {
+			return corners ? cube.get_corner_pos(position) : cube.get_edge_pos(position*cube.get_edge_width());
+		};
+
+		coordinate.get = [orbits, get_piece](const cube::Cube& cube) {
+			int value = 0;
+			for (const auto& orbit : orbits) {
+				std::vector<int> permutation;
+				for (const int position : orbit) {
+					int piece = get_piece(cube, position);
+					permutation.push_back(std::find(orbit.begin(), orbit.end(), piece) - orbit.begin());
+				}
+				int orbit_permutations = 1;
+				for (int i = 2; i <= orbit.size(); i++) {
+					orbit_permutations *= i;
+				}
+				value = value*orbit_permutations + rank_permutation(permutation);
+			}
+
+			return value;
+		};
+		coordinate.set = [orbits, corners](int value) {
+			auto edges = solved_edges();
+			auto pieces = solved_corners();
+			for (auto it = orbits.rbegin(); it != orbits.rend(); it++) {
+				int orbit_permutations = 1;
+				for (int i = 2; i <= it->size(); i++) {
+					orbit_permutations *= i;
+				}
+				auto permutation = unrank_permutation(value%orbit_permutations, it->size());
+				value /= orbit_permutations;
+				for (int i = 0; i < it->size(); i++) {
+					(corners ? pieces[(*it)[i]] : edges[(*it)[i]]) = (*it)[permutation[i]];
+				}
+			}
+
+			return create_cube(edges, pieces);
+		};
+
+		return coordinate;
+	}
+
+	//returns the coordinate ranking only the values of the given coordinate that the given twist sequences
+	//reach from the solved cube, in increasing order. The rank of every value is kept in a table indexed
+	//by the value
+	Coordinate rank_reachable_values(const Coordinate& coordinate, const std::vector<TwistSequence>& twist_sequences) {
+		auto ranks = std::make_shared<std::vector<int>>(coordinate.count, -1);
+		std::vector<int> open = {coordinate.get(cube::Cube(3))};
+		(*ranks)[open.front()] = 0;
+		for (int i = 0; i < open.size(); i++) {
+			auto cube = coordinate.set(open[i]);
+			for (const auto& twist_seq : twist_sequences) {
+				cube::Cube child(cube);
+				for (const auto& twist : twist_seq) {
+					child.rotate(twist);
+				}
+				int value = coordinate.get(child);
+				if ((*ranks)[value] == -1) {
+					(*ranks)[value] = 0;
+					open.push_back(value);
+				}
+			}
+		}
+
+		auto values = std::make_shared<std::vector<int>>(open);
+		std::sort(values->begin(), values->end());
+		for (int rank = 0; rank < values->size(); rank++) {
+			(*ranks)[(*values)[rank]] = rank;
+		}
+
+		Coordinate reachable_coordinate;
+		reachable_coordinate.count = values->size();
+		reachable_coordinate.get = [coordinate, ranks](const cube::Cube& cube) {
+			return (*ranks)[coordinate.get(cube)];
+		};
+		reachable_coordinate.set = [coordinate, values](const int rank) {
+			return coordinate.set((*values)[rank]);
+		};
+
+		return reachable_coordinate;
+	}
+}
+
+const std::unordered_map<int, int> ThreeCubeSolver::edge_slices {
+	{4,0}, {5,0}, {6,0}, {7,0},
+	{0,1}, {2,1}, {8,1}, {10,1},
+	{3,2}, {1,2}, {11,2}, {9,2},
+};
+
+ThreeCubeSolver::ThreeCubeSolver(const bool compress_tables) : table_dir("tables") {
+	if (!boost::filesystem::exists(table_dir)) {
+		boost::filesystem::create_directory(table_dir);
+	}
+	//the stages are independent, so their tables are loaded, or generated, at the same time
+	std::array<std::exception_ptr, stage_count> errors;
+	std::vector<std::thread> threads;
+	for (int stage = 0; stage < stage_count; stage++) {
+		threads.emplace_back([&, stage]() {
+			try {
+				auto file_path = table_dir/filenames[stage];
+				stages[stage] = StageTableRegistry::get_instance().get_table(file_path, [&]() {
+					auto twist_sequences = generate_stage_moves(stage);
+					return std::make_unique<StageTable>(file_path, stage, create_coordinates(stage, twist_sequences), twist_sequences,
+						compress_tables);
+				});
+			}
+			catch (...) {
+				errors[stage] = std::current_exception();
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	for (const auto& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
 }
 
 std::vector<cube::Twist> ThreeCubeSolver::orient_cube(const cube::CubeCenters& centers) {
@@ -59,7 +299,7 @@ std::vector<cube::Twist> ThreeCubeSolver::orient_cube(const cube::CubeCenters& c
 		return true;
 	};
 
-	return search::breadth_first_search<cube::CubeCenters>(centers, TwistUtils::generate_cube_rotations(centers), is_finished);
+	return search::breadth_first_search<cube::CubeCenters>(centers, TwistUtils::generate_cube_rotations(centers), is_finished).twists;
 }
 
 bool ThreeCubeSolver::even_corner_parity(const cube::Cube& cube) {
@@ -182,21 +422,6 @@ TwistSequence ThreeCubeSolver::solve_parity(const cube::Cube& cube) {
 	return TwistSequence();
 }
 
-std::vector<cube::Twist> ThreeCubeSolver::get_twists(const CubeState<cube::Cube>* state) {
-	std::vector<cube::Twist> twists;
-
-	auto curr_ptr = state;
-	while (curr_ptr->parent != nullptr) {
-		for (const auto& twist : curr_ptr->twist_seq.get()) {
-			twists.push_back(cube::Twist(-twist.degrees, twist.face, twist.layer, twist.wide_turn));
-		}
-		curr_ptr = curr_ptr -> parent.get();	
-	}
-	
-	return twists;	
-
-}
-
 std::vector<TwistSequence> ThreeCubeSolver::generate_twist_sequences(const std::unordered_set<cube::Face>& restricted_faces) {
 	std::vector<TwistSequence> twist_sequences;
 	for (const auto face : cube::ALL_FACES) {
@@ -216,172 +441,205 @@ std::vector<TwistSequence> ThreeCubeSolver::generate_twist_sequences(const std::
 	return twist_sequences;
 }
 
-void ThreeCubeSolver::save_lookup_table(const ThreeCubeSolver::LookupTable& table, std::string file_path) {
-	typedef std::pair<std::vector<char>, std::vector<cube::Twist>> TableEntry;
-	std::vector<TableEntry> sorted_entries;
-	for (const auto& entry : table) {
-		sorted_entries.push_back(std::make_pair(convert_encoding(entry.first), entry.second));
-	}
-	auto entry_compare = [](const TableEntry& lhs, const TableEntry& rhs) {
-		return lhs.first < rhs.first;
-	};
-	std::sort(sorted_entries.begin(), sorted_entries.end(), entry_compare);
-	
-	std::ofstream file(file_path, std::ofstream::binary);
-	for (const auto& entry : sorted_entries) {
-		file.write(&entry.first[0], entry.first.size());
-		std::vector<char> twists_encoding;
-		for (const auto& twist : entry.second) {
-			twists_encoding.push_back(twist_mappings.left.at(twist));
-		}
-		while (twists_encoding.size() < twists_encoding_length) {
-			twists_encoding.push_back(0);	
-		}
-		file.write(&twists_encoding[0], twists_encoding.size());
-	}
-}
-
-void ThreeCubeSolver::build_encoding(std::vector<bool>& encoding, const uint8_t data, const int bits) {
-	for (int i = 0; i < bits; i++) {
-		bool bit = (data >> i) & 1;
-		encoding.push_back(bit);
-	}
-}
-
-std::vector<bool> ThreeCubeSolver::encode_g1(const cube::Cube& cube) {
-	std::vector<bool> encoding;
-	for (int edge = 0; edge < cube.get_edge_count(); edge++) {
-		build_encoding(encoding, get_edge_orientation(cube, edge), 1);
-	}
-	
-	return encoding;
-}
+std::vector<TwistSequence> ThreeCubeSolver::generate_stage_moves(const int stage) {
+	using namespace cube;
+	//the faces restricted at each stage are only turned by half twists
+	std::array<std::unordered_set<Face>, stage_count> restricted_faces = {{
+		{},
+		{Face::TOP, Face::BOTTOM},	
+		{Face::TOP, Face::BOTTOM, Face::FRONT, Face::BACK},
+		{Face::TOP, Face::BOTTOM, Face::FRONT, Face::BACK, Face::LEFT, Face::RIGHT},
+	}};
 
-std::vector<bool> ThreeCubeSolver::encode_g2(const cube::Cube& cube) {
-	std::vector<bool> encoding;
-	for (int corner = 0; corner < cube.get_corner_count(); corner++) {
-		build_encoding(encoding, cube.get_corner_orientation(corner), 2);
-	}
-	for (int edge = 0; edge < cube.get_edge_count(); edge++) {
-		build_encoding(encoding, edge_slices[get_edge_pos(cube, edge)]==1, 1);
-	}
-	
-	return encoding;
+	return generate_twist_sequences(restricted_faces.at(stage));
 }
 
-std::vector<bool> ThreeCubeSolver::encode_g3(const cube::Cube& cube) {
-	std::vector<bool> encoding;
-	
-	static std::unordered_map<int, int> corner_pair_groups = {
-		{0, 0}, {2, 0}, 
-		{3, 1}, {1, 1}, 
-		{4, 2}, {6, 2},
-		{7, 3}, {5, 3},
-	};
-
-	for (int corner = 0; corner < cube.get_corner_count(); corner++) {
-		build_encoding(encoding, corner_pair_groups[cube.get_corner_pos(corner)], 2);
+std::vector<Coordinate> ThreeCubeSolver::create_coordinates(const int stage, const std::vector<TwistSequence>& twist_sequences) {
+	//the edges that belong in each slice, in increasing order
+	std::array<std::vector<int>, 3> slice_edges;
+	for (int edge = 0; edge < 12; edge++) {
+		slice_edges[edge_slices.at(edge)].push_back(edge);
 	}
-	for (int edge = 0; edge < cube.get_edge_count(); edge++) {
-		if (edge_slices[get_edge_pos(cube, edge)] != 1) {
-			build_encoding(encoding, edge_slices[get_edge_pos(cube, edge)], 2);
-		}
-	}
-	build_encoding(encoding, even_corner_parity(cube), 1);
-	
-	return encoding;
-}
+	auto slices = edge_slices;
+
+	if (stage == 0) {
+		//the orientation of every edge but the last, which is flipped if an odd number of the others are
+		Coordinate edge_orientation;
+		edge_orientation.count = 1 << 11;
+		edge_orientation.get = [](const cube::Cube& cube) {
+			int value = 0;
+			for (int edge = 0; edge < 11; edge++) {
+				value |= get_edge_orientation(cube, edge) << edge;
+			}
+			return value;
+		};
+		edge_orientation.set = [](const int value) {
+			auto edges = solved_edges();
+			int flipped_edges = 0;
+			for (int edge = 0; edge < 11; edge++) {
+				edges[edge] |= ((value >> edge) & 1) << 7;
+				flipped_edges += (value >> edge) & 1;
+			}
+			edges[11] |= (flipped_edges%2) << 7;
+			return create_cube(edges, solved_corners());
+		};
 
-std::vector<bool> ThreeCubeSolver::encode_g4(const cube::Cube& cube) {
-	std::vector<bool> encoding;
-	for (int edge = 0; edge < cube.get_edge_count(); edge++) {
-		build_encoding(encoding, get_edge_pos(cube, edge), 4);
+		return {edge_orientation};
 	}
-	for (int corner = 0; corner < cube.get_corner_count(); corner++) {
-		build_encoding(encoding, cube.get_corner_pos(corner), 4);
-	}
-
-	return encoding;
-}
+	else if (stage == 1) {
+		//the orientation of every corner but the last as the digits of a number in base 3. The orientations
+		//of all the corners always add up to a multiple of 3, which gives the last one
+		Coordinate corner_orientation;
+		corner_orientation.count = 2187;
+		corner_orientation.get = [](const cube::Cube& cube) {
+			int value = 0;
+			for (int corner = 6; corner >= 0; corner--) {
+				value = value*3 + cube.get_corner_orientation(corner);
+			}
+			return value;
+		};
+		corner_orientation.set = [](int value) {
+			auto corners = solved_corners();
+			int orientation_sum = 0;
+			for (int corner = 0; corner < 7; corner++) {
+				corners[corner] |= (value%3) << 3;
+				orientation_sum += value%3;
+				value /= 3;
+			}
+			corners[7] |= ((3 - orientation_sum%3)%3) << 3;
+			return create_cube(solved_edges(), corners);
+		};
+
+		//the positions of the edges that belong in slice 1
+		Coordinate slice;
+		slice.count = choose(12, 4);
+		slice.get = [slices](const cube::Cube& cube) {
+			std::vector<bool> chosen;
+			for (int edge = 0; edge < 12; edge++) {
+				chosen.push_back(slices.at(get_edge_pos(cube, edge)) == 1);
+			}
+			return rank_combination(chosen);
+		};
+		slice.set = [slice_edges](const int value) {
+			auto chosen = unrank_combination(value, 12, 4);
+			std::array<uint8_t, 12> edges;
+			auto slice_edge = slice_edges[1].begin();
+			auto other_edge = slice_edges[0].begin();
+			for (int edge = 0; edge < 12; edge++) {
+				if (chosen[edge]) {
+					edges[edge] = *slice_edge++;
+				}
+				else {
+					edges[edge] = *other_edge++;
+					if (other_edge == slice_edges[0].end()) {
+						other_edge = slice_edges[2].begin();
+					}
+				}
+			}
+			return create_cube(edges, solved_corners());
+		};
 
-std::vector<char> ThreeCubeSolver::convert_encoding(const std::vector<bool>& encoding) {
-	uint8_t buffer = 0;
-	uint8_t buffer_index = 0;
-	std::vector<char> converted_encoding;
-	for (const bool b : encoding) {
-		buffer |= b << buffer_index;
-		buffer_index++;
-		if (buffer_index == 8) {
-			converted_encoding.push_back(buffer);
-			buffer = 0;
-			buffer_index = 0;
-		}
-	}
-	converted_encoding.push_back(buffer);
-	while (converted_encoding.size() < cube_encoding_length) {
-		converted_encoding.push_back(0);
+		return {corner_orientation, slice};
 	}
-	
-	return converted_encoding;
-}
-
-std::unordered_map<std::vector<bool>, std::vector<cube::Twist>> ThreeCubeSolver::create_lookup_table(
-			const std::function<std::vector<bool>(const cube::Cube&)> encoder, 
-			const std::vector<TwistSequence> twist_sequences) {
-
-		std::queue<std::shared_ptr<State>> open;
-	       	open.push(std::make_shared<State>(cube::Cube(3)));
-		LookupTable table;
-		while (open.size() > 0) {
-			auto& curr_state = open.front();
-			for (const auto& twist_seq : twist_sequences) {
-				cube::Cube child_cube(curr_state->cube);
-				for (const auto& twist : twist_seq) {
-					child_cube.rotate(twist);
+	else if (stage == 2) {
+		static const std::array<int, 8> corner_pair_groups = {0, 1, 0, 1, 2, 3, 2, 3};
+
+		//the positions of the corners of each pair, the first three pairs each chosen from the positions
+		//left by the pairs before it
+		Coordinate corner_pairs;
+		corner_pairs.count = choose(8, 2)*choose(6, 2)*choose(4, 2);
+		corner_pairs.get = [](const cube::Cube& cube) {
+			int value = 0;
+			std::vector<int> groups;
+			for (int corner = 0; corner < 8; corner++) {
+				groups.push_back(corner_pair_groups[cube.get_corner_pos(corner)]);
+			}
+			for (int group = 0; group < 3; group++) {
+				std::vector<bool> chosen;
+				for (const int position_group : groups) {
+					chosen.push_back(position_group == group);
 				}
-
-				auto child_ptr = std::make_shared<State>(curr_state, std::move(child_cube), twist_seq);
-				auto child_encoding = encoder(child_cube);
-				if (!table.count(child_encoding)) {
-					table.insert(std::make_pair(child_encoding, get_twists(child_ptr.get())));
-					open.push(child_ptr);
-				}	
+				value = value*choose(groups.size(), 2) + rank_combination(chosen);
+				groups.erase(std::remove(groups.begin(), groups.end(), group), groups.end());
 			}
-			open.pop();
-		}
-
-		return table;
-}
-
-std::vector<cube::Twist> ThreeCubeSolver::find_table_entry(
-		const std::vector<bool>& target_encoding,
-		const boost::iostreams::mapped_file_source& table) {
-
-	auto converted_encoding = convert_encoding(target_encoding);
-	const char* lower_bound = table.begin();
-	const char* upper_bound = table.end()-table_entry_length;
-	while (1) {
-		int table_entries_in_range = std::distance(lower_bound, upper_bound)/table_entry_length;
-		auto pivot = lower_bound + (table_entries_in_range/2)*table_entry_length;
-		if (std::equal(pivot, pivot+cube_encoding_length, &converted_encoding[0])) {
-			std::vector<cube::Twist> solution;
-			for (int i = cube_encoding_length; i < table_entry_length; i++) {
-				if (pivot[i] == 0) {
-					break;
+			return value;
+		};
+		corner_pairs.set = [](int value) {
+			std::array<int, 3> ranks;
+			for (int group = 2; group >= 0; group--) {
+				ranks[group] = value%choose(8 - 2*group, 2);
+				value /= choose(8 - 2*group, 2);
+			}
+			std::vector<int> free_positions = {0, 1, 2, 3, 4, 5, 6, 7};
+			auto corners = solved_corners();
+			for (int group = 0; group < 4; group++) {
+				auto chosen = group < 3 ? unrank_combination(ranks[group], free_positions.size(), 2) : std::vector<bool>(2, true);
+				std::vector<int> pieces;
+				for (int corner = 0; corner < 8; corner++) {
+					if (corner_pair_groups[corner] == group) {
+						pieces.push_back(corner);
+					}
+				}
+				std::vector<int> used_positions;
+				for (int i = 0; i < free_positions.size(); i++) {
+					if (chosen[i]) {
+						corners[free_positions[i]] = pieces[used_positions.size()];
+						used_positions.push_back(free_positions[i]);
+					}
 				}
-				solution.push_back(twist_mappings.right.at(pivot[i]));
+				for (const int position : used_positions) {
+					free_positions.erase(std::find(free_positions.begin(), free_positions.end(), position));
+				}
+			}
+			return create_cube(solved_edges(), corners);
+		};
+
+		//the positions of the edges of slice 0 among the positions outside slice 1
+		std::vector<int> outer_positions(slice_edges[0]);
+		outer_positions.insert(outer_positions.end(), slice_edges[2].begin(), slice_edges[2].end());
+		std::sort(outer_positions.begin(), outer_positions.end());
+		Coordinate slice_placement;
+		slice_placement.count = choose(8, 4);
+		slice_placement.get = [slices, outer_positions](const cube::Cube& cube) {
+			std::vector<bool> chosen;
+			for (const int position : outer_positions) {
+				chosen.push_back(slices.at(get_edge_pos(cube, position)) == 0);
+			}
+			return rank_combination(chosen);
+		};
+		slice_placement.set = [slice_edges, outer_positions](const int value) {
+			auto chosen = unrank_combination(value, outer_positions.size(), 4);
+			auto edges = solved_edges();
+			auto slice_edge = slice_edges[0].begin();
+			auto other_edge = slice_edges[2].begin();
+			for (int i = 0; i < outer_positions.size(); i++) {
+				edges[outer_positions[i]] = chosen[i] ? *slice_edge++ : *other_edge++;
 			}
+			return create_cube(edges, solved_corners());
+		};
+
+		Coordinate corner_parity;
+		corner_parity.count = 2;
+		corner_parity.get = [](const cube::Cube& cube) {
+			return even_corner_parity(cube) ? 0 : 1;
+		};
+		corner_parity.set = [](const int value) {
+			auto corners = solved_corners();
+			if (value == 1) {
+				std::swap(corners[0], corners[1]);
+			}
+			return create_cube(solved_edges(), corners);
+		};
 
-			return solution;
-		}
-		else if (std::lexicographical_compare(pivot, pivot+cube_encoding_length, 
-					&converted_encoding[0], &converted_encoding[0]+cube_encoding_length)) {
-			lower_bound = pivot+table_entry_length;
-		}
-		else {
-			upper_bound = pivot-table_entry_length;
-		}
+		return {corner_pairs, slice_placement, corner_parity};
 	}
+	
+	//the half twists keep the corners in two orbits and the edges in their slices. Only 96 of the permutations
+	//of the corners within their orbits can be reached with half twists, so they are ranked among those
+	return {
+		rank_reachable_values(create_orbit_permutation_coordinate(find_orbits(twist_sequences, true), true), twist_sequences),
+		create_orbit_permutation_coordinate(find_orbits(twist_sequences, false), false),
+	};
 }
 
 void ThreeCubeSolver::execute_partial_solution(const TwistSequence& twist_sequence, cube::CombinedCube& comb_cube) {
@@ -398,9 +656,7 @@ void ThreeCubeSolver::solve(const cube::CombinedCube& comb_cube) {
 	execute_partial_solution(solve_parity(curr_state.get_cube()), curr_state);
 
 	for (int stage = 0; stage < stage_count; stage++) {
-		auto table_path = table_dir/filenames[stage];
-		boost::iostreams::mapped_file_source table(table_path.string());
-		execute_partial_solution(find_table_entry(encoders[stage](comb_cube.get_cube()), table), curr_state);
+		execute_partial_solution(stages[stage]->solve(curr_state.get_cube()), curr_state);
 		std::cout << "Stage " << stage << " complete\n";
 	}
 }
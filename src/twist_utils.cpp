@@ -1,6 +1,12 @@
 #include "twist_utils.h"
 #include "cube_base.h"
 #include "twist.h"
+#include "cube_centers.h"
+#include "cube.h"
+#include <sstream>
+#include <numeric>
+#include <functional>
+#include <algorithm>
 
 using namespace ai;
 using namespace TwistUtils;
@@ -16,6 +22,15 @@ std::vector<TwistSequence> TwistUtils::generate_face_twists() {
 	return twist_sequences;
 }
 
+TwistSequence TwistUtils::invert(const TwistSequence& twist_seq) {
+	TwistSequence inverse;
+	for (auto it = twist_seq.rbegin(); it != twist_seq.rend(); it++) {
+		inverse.push_back(cube::Twist(-it->degrees, it->face, it->layer, it->wide_turn));
+	}
+
+	return inverse;
+}
+
 std::vector<TwistSequence> TwistUtils::generate_cube_rotations(const cube::CubeBase& cube) {
 	using namespace cube;
 	std::vector<TwistSequence> twist_sequences;
@@ -27,3 +42,108 @@ std::vector<TwistSequence> TwistUtils::generate_cube_rotations(const cube::CubeB
 	
 	return twist_sequences;
 }
+
+std::vector<int> TwistUtils::trace_center_pieces(const int size, const TwistSequence& twist_seq) {
+	cube::CubeCenters solved(size);
+	std::stringstream solved_stream;
+	solved.write(solved_stream);
+	std::string solved_pieces = solved_stream.str();
+
+	//the pieces are given distinct values, in batches small enough for the values to fit in a byte, and followed
+	//through the twists. Pieces outside the batch are given the value 255
+	int piece_count = solved.get_pieces_in_center()*cube::ALL_FACES.size();
+	int batch_size = 255;
+	std::vector<int> destinations(piece_count);
+	for (int batch_start = 0; batch_start < piece_count; batch_start += batch_size) {
+		std::string pieces(solved_pieces);
+		std::fill(pieces.begin(), pieces.begin() + piece_count, static_cast<char>(255));
+		int batch_end = std::min(piece_count, batch_start + batch_size);
+		for (int i = batch_start; i < batch_end; i++) {
+			pieces[i] = static_cast<char>(i - batch_start);
+		}
+
+		cube::CubeCenters centers(size);
+		std::istringstream stream(pieces);
+		centers.read(stream);
+		for (const auto& twist : twist_seq) {
+			centers.rotate(twist);
+		}
+		for (int i = 0; i < piece_count; i++) {
+			int value = centers.get_center_pos(i);
+			if (value != 255) {
+				destinations[batch_start + value] = i;
+			}
+		}
+	}
+
+	return destinations;
+}
+
+std::vector<std::pair<int, bool>> TwistUtils::trace_wings(const int size, const TwistSequence& twist_seq) {
+	cube::Cube solved(size);
+	std::stringstream solved_stream;
+	solved.write(solved_stream);
+	std::string solved_pieces = solved_stream.str();
+
+	//the wings are given distinct positions, in batches small enough for the positions to fit in the 7 position
+	//bits, and followed through the twists. Wings outside the batch are given the position 127
+	int wing_count = solved.get_edge_width()*solved.get_edge_count();
+	int batch_size = 127;
+	std::vector<std::pair<int, bool>> destinations(wing_count);
+	for (int batch_start = 0; batch_start < wing_count; batch_start += batch_size) {
+		std::string pieces(solved_pieces);
+		std::fill(pieces.begin(), pieces.begin() + wing_count, static_cast<char>(127));
+		int batch_end = std::min(wing_count, batch_start + batch_size);
+		for (int i = batch_start; i < batch_end; i++) {
+			pieces[i] = static_cast<char>(i - batch_start);
+		}
+
+		cube::Cube cube(size);
+		std::istringstream stream(pieces);
+		cube.read(stream);
+		for (const auto& twist : twist_seq) {
+			cube.rotate(twist);
+		}
+		for (int i = 0; i < wing_count; i++) {
+			int value = cube.get_edge_pos(i);
+			if (value != 127) {
+				destinations[batch_start + value] = {i, cube.get_edge_orientation(i) != 0};
+			}
+		}
+	}
+
+	return destinations;
+}
+
+std::vector<std::vector<int>> TwistUtils::find_center_orbits(const int size) {
+	cube::CubeCenters solved(size);
+	int piece_count = solved.get_pieces_in_center()*cube::ALL_FACES.size();
+
+	//the orbits are the connected components of the pieces, connected by rotations of each slice
+	std::vector<int> parents(piece_count);
+	std::iota(parents.begin(), parents.end(), 0);
+	std::function<int(int)> find_root = [&parents, &find_root](const int piece) {
+		return parents[piece] == piece ? piece : parents[piece] = find_root(parents[piece]);
+	};
+	for (const auto& axis : AXIS_FACES) {
+		for (int layer = 0; layer < size; layer++) {
+			auto destinations = trace_center_pieces(size, {cube::Twist(90, axis, layer, false)});
+			for (int piece = 0; piece < piece_count; piece++) {
+				parents[find_root(piece)] = find_root(destinations[piece]);
+			}
+		}
+	}
+
+	std::vector<std::vector<int>> components(piece_count);
+	for (int piece = 0; piece < piece_count; piece++) {
+		components[find_root(piece)].push_back(piece);
+	}
+	std::vector<std::vector<int>> orbits;
+	for (const auto& component : components) {
+		if (component.size() == 24) {
+			orbits.push_back(component);
+		}
+	}
+
+	return orbits;
+}
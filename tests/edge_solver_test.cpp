@@ -0,0 +1,100 @@
+#include "edge_solver.h"
+#include "combined_cube.h"
+#include "twist_listener.h"
+#include "twist_utils.h"
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+using namespace ai;
+
+namespace {
+	//applies the twists of the solver to a cube
+	class CubeTwister : public TwistListener {
+		private:
+			cube::CombinedCube& cube;
+
+		public:
+			CubeTwister(cube::CombinedCube& cube) : cube(cube) {}
+
+			void twist(const cube::Twist& twist) override {
+				cube.rotate(twist);
+			}
+	};
+
+	//returns a cube of the given size with only its edges and corners scrambled, which the edge solver can't tell
+	//apart from a cube that had its centers solved
+	cube::CombinedCube scramble_edges(const int size, const int seed) {
+		cube::CombinedCube cube(size);
+		std::mt19937 random(seed);
+		for (int i = 0; i < 60; i++) {
+			int layer = random()%size;
+			cube.get_cube().rotate(cube::Twist(random()%2 ? 90 : -90, TwistUtils::AXIS_FACES[random()%3], layer, false));
+		}
+
+		return cube;
+	}
+
+	//pairs the edges of a cube of the given size whose centers are solved with the orbit-parallel mode, and returns
+	//false if the edges aren't paired or the centers aren't solved afterwards
+	bool test_orbit_parallel_keeps_centers(const int size, const int seed) {
+		auto cube = scramble_edges(size, seed);
+
+		EdgeSolverSettings settings;
+		settings.orbit_parallel = true;
+		settings.refinement_budget = std::chrono::milliseconds(0);
+		EdgeSolver solver(search::SearchLimits(), settings);
+		CubeTwister twister(cube);
+		solver.add_twist_listener(&twister);
+		auto status = solver.solve(cube.get_cube());
+
+		const auto& centers = cube.get_cube_centers();
+		int center_pieces = centers.get_pieces_in_center()*cube::ALL_FACES.size();
+		bool passed = status == search::SearchStatus::SOLVED && cube.get_cube().get_paired_edges() == 0xfff &&
+			centers.get_solved_piece_count() == center_pieces;
+		if (!passed) {
+			std::cerr << size << "x" << size << " seed " << seed << ": status " << status << ", paired edges " << std::hex << 
+				cube.get_cube().get_paired_edges() << std::dec << ", solved center pieces " << centers.get_solved_piece_count() << 
+				"/" << center_pieces << "\n";
+		}
+
+		return passed;
+	}
+
+	//pairs the edges of an even cube with the orbit-parallel mode and wing swaps that aren't set up, which can't pair
+	//every orbit. Returns false unless the search of the orbit that can't be paired throws its error to the caller
+	bool test_orbit_parallel_unpairable_orbit(const int size, const int seed) {
+		auto cube = scramble_edges(size, seed);
+		EdgeSolverSettings settings;
+		settings.orbit_parallel = true;
+		settings.orbit_setup_depth = 0;
+		//the orbits are searched on more than one thread whatever the machine, so an exception leaving a
+		//worker would terminate the test
+		settings.orbit_threads = 2;
+		EdgeSolver solver(search::SearchLimits(), settings);
+		try {
+			solver.solve(cube.get_cube());
+		}
+		catch (const std::invalid_argument&) {
+			return true;
+		}
+		std::cerr << size << "x" << size << " seed " << seed << ": the orbit that can't be paired didn't throw\n";
+
+		return false;
+	}
+}
+
+int main() {
+	bool passed = true;
+	for (int size = 4; size <= 7; size++) {
+		for (int seed = 1; seed <= 3; seed++) {
+			passed = test_orbit_parallel_keeps_centers(size, seed) && passed;
+		}
+	}
+	for (int size = 4; size <= 6; size += 2) {
+		passed = test_orbit_parallel_unpairable_orbit(size, 1) && passed;
+	}
+	std::cout << (passed ? "All tests passed\n" : "Tests failed\n");
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+#include "search.h"
+#include "hash.h"
+#include "cube_centers.h"
+#include "twist_utils.h"
+#include <iostream>
+#include <random>
+
+using namespace ai;
+
+namespace {
+	//returns a TwistSequence for every single layer twist of a cube of the given size
+	std::vector<TwistSequence> generate_single_twists(const int size) {
+		std::vector<TwistSequence> twist_sequences;
+		for (const auto axis : TwistUtils::AXIS_FACES) {
+			for (int layer = 0; layer < size; layer++) {
+				for (const int degrees : TwistUtils::DEGREES) {
+					twist_sequences.push_back(TwistSequence({cube::Twist(degrees, axis, layer, false)}));
+				}
+			}
+		}
+
+		return twist_sequences;
+	}
+
+	//solves the centers of a scrambled 4x4 with breadth-first searches in memory and on disk, with runs small enough
+	//to be merged, and returns false if the searches don't find solutions of the same length that solve the centers
+	bool test_external_breadth_first_search(const int seed) {
+		const int size = 4;
+		auto twist_sequences = generate_single_twists(size);
+		cube::CubeCenters centers(size);
+		std::mt19937 random(seed);
+		//an inner slice of each axis, which the searches can't solve in fewer than 3 twists
+		for (const auto axis : TwistUtils::AXIS_FACES) {
+			centers.rotate(cube::Twist(TwistUtils::DEGREES[random()%2], axis, 1 + random()%(size-2), false));
+		}
+		auto is_finished = [](const cube::CubeCenters& centers) {
+			return centers.get_solved_piece_count() == centers.get_pieces_in_center()*static_cast<int>(cube::ALL_FACES.size());
+		};
+
+		auto in_memory = search::breadth_first_search<cube::CubeCenters>(centers, twist_sequences, is_finished);
+		search::ExternalSearchSettings external(boost::filesystem::temp_directory_path());
+		external.run_memory = 1 << 16;
+		auto on_disk = search::breadth_first_search<cube::CubeCenters>(centers, twist_sequences, is_finished, search::SearchLimits(), external);
+
+		cube::CubeCenters solved(centers);
+		for (const auto& twist : on_disk.twists) {
+			solved.rotate(twist);
+		}
+		bool passed = in_memory.solved() && on_disk.solved() && in_memory.twists.size() == on_disk.twists.size() && is_finished(solved);
+		if (!passed) {
+			std::cerr << "seed " << seed << ": " << in_memory.twists.size() << " twists in memory, " << on_disk.twists.size() << 
+				" twists on disk, solved center pieces " << solved.get_solved_piece_count() << "\n";
+		}
+
+		return passed;
+	}
+}
+
+int main() {
+	bool passed = true;
+	for (int seed = 1; seed <= 3; seed++) {
+		passed = test_external_breadth_first_search(seed) && passed;
+	}
+	std::cout << (passed ? "All tests passed\n" : "Tests failed\n");
+
+	return passed ? 0 : 1;
+}
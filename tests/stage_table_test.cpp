@@ -0,0 +1,136 @@
+#include "stage_table.h"
+#include "three_cube_solver.h"
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <random>
+#include <functional>
+
+using namespace ai;
+
+namespace {
+	//stage 1 has about a million states, so its compressed tables hold several blocks
+	constexpr int stage = 1;
+
+	//offsets of the fields of the file header
+	constexpr std::size_t version_offset = 4;
+	constexpr std::size_t stage_offset = 8;
+	constexpr std::size_t key_offset = 16;
+	constexpr std::size_t header_length = 40;
+
+	std::string read_file(const boost::filesystem::path& path) {
+		std::ifstream file(path.string(), std::ifstream::binary);
+		std::stringstream contents;
+		contents << file.rdbuf();
+
+		return contents.str();
+	}
+
+	void write_file(const boost::filesystem::path& path, const std::string& contents) {
+		std::ofstream file(path.string(), std::ofstream::binary | std::ofstream::trunc);
+		file.write(contents.data(), contents.size());
+	}
+
+	//loads the table of the stage from the given path, and sets 'generated' if it had to be generated
+	std::unique_ptr<StageTable> load_table(const boost::filesystem::path& path, const bool compressed, bool& generated) {
+		std::stringstream log;
+		auto cout_buffer = std::cout.rdbuf(log.rdbuf());
+		std::unique_ptr<StageTable> table;
+		try {
+			table = std::make_unique<StageTable>(path, stage, ThreeCubeSolver::create_coordinates(stage, ThreeCubeSolver::generate_stage_moves(stage)),
+					ThreeCubeSolver::generate_stage_moves(stage), compressed);
+		}
+		catch (...) {
+			std::cout.rdbuf(cout_buffer);
+			throw;
+		}
+		std::cout.rdbuf(cout_buffer);
+		generated = log.str().find("Generating") != std::string::npos;
+
+		return table;
+	}
+
+	//returns false if the given table doesn't bring scrambles made with the moves of the stage to its solved state
+	bool solves_scrambles(const StageTable& table) {
+		auto moves = ThreeCubeSolver::generate_stage_moves(stage);
+		auto coordinates = ThreeCubeSolver::create_coordinates(stage, moves);
+		std::mt19937 random(1);
+		for (int scramble = 0; scramble < 20; scramble++) {
+			cube::Cube cube(3);
+			for (int i = 0; i < 30; i++) {
+				for (const auto& twist : moves[random()%moves.size()]) {
+					cube.rotate(twist);
+				}
+			}
+			for (const auto& twist : table.solve(cube)) {
+				cube.rotate(twist);
+			}
+			for (const auto& coordinate : coordinates) {
+				if (coordinate.get(cube) != coordinate.get(cube::Cube(3))) {
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	//generates a table, corrupts its file with 'corrupt' and loads it again. Returns false if the table isn't
+	//generated again when 'corrupt' changed the file, is generated again when it didn't, or doesn't solve the stage
+	bool test_load(const std::string& name, const bool compressed, const std::function<void(std::string&)>& corrupt) {
+		auto dir = boost::filesystem::temp_directory_path()/boost::filesystem::unique_path("stage-table-%%%%-%%%%");
+		boost::filesystem::create_directories(dir);
+		auto path = dir/"table.bin";
+		bool passed = true;
+		try {
+			bool generated;
+			load_table(path, compressed, generated);
+			auto original = read_file(path);
+			auto corrupted = original;
+			corrupt(corrupted);
+			write_file(path, corrupted);
+
+			auto table = load_table(path, compressed, generated);
+			if (generated != (corrupted != original)) {
+				std::cerr << name << ": the table was " << (generated ? "" : "not ") << "generated again\n";
+				passed = false;
+			}
+			if (read_file(path) != original) {
+				std::cerr << name << ": the file doesn't hold the generated table\n";
+				passed = false;
+			}
+			if (!solves_scrambles(*table)) {
+				std::cerr << name << ": the loaded table doesn't solve the stage\n";
+				passed = false;
+			}
+		}
+		catch (const std::exception& e) {
+			std::cerr << name << ": " << e.what() << "\n";
+			passed = false;
+		}
+		boost::filesystem::remove_all(dir);
+
+		return passed;
+	}
+}
+
+int main() {
+	bool passed = true;
+	for (const bool compressed : {false, true}) {
+		std::string format = compressed ? "compressed " : "";
+		passed = test_load(format + "intact", compressed, [](std::string&) {}) && passed;
+		passed = test_load(format + "old version", compressed, [](std::string& file) {file[version_offset]--;}) && passed;
+		passed = test_load(format + "other stage", compressed, [](std::string& file) {file[stage_offset]++;}) && passed;
+		passed = test_load(format + "stale key", compressed, [](std::string& file) {file[key_offset] ^= 1;}) && passed;
+		passed = test_load(format + "truncated header", compressed, [](std::string& file) {file.resize(header_length/2);}) && passed;
+		passed = test_load(format + "truncated table", compressed, [](std::string& file) {file.resize(file.size()-1);}) && passed;
+		passed = test_load(format + "flipped byte", compressed, [](std::string& file) {
+			file[header_length + (file.size()-header_length)/2] ^= 0x55;
+		}) && passed;
+		passed = test_load(format + "flipped last byte", compressed, [](std::string& file) {file.back() ^= 0x55;}) && passed;
+	}
+	std::cout << (passed ? "All tests passed\n" : "Tests failed\n");
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,40 @@
+#include "three_cube_solver.h"
+#include <iostream>
+
+using namespace ai;
+
+namespace {
+	//returns false if a value of a coordinate of the given stage doesn't survive setting it on a cube and reading
+	//it back. The stage tables index their states by these values, so a coordinate that doesn't round-trip would
+	//give states the distances of others
+	bool test_coordinates_round_trip(const int stage) {
+		auto coordinates = ThreeCubeSolver::create_coordinates(stage, ThreeCubeSolver::generate_stage_moves(stage));
+		bool passed = true;
+		for (int i = 0; i < coordinates.size(); i++) {
+			int failures = 0;
+			for (int value = 0; value < coordinates[i].count; value++) {
+				int read_value = coordinates[i].get(coordinates[i].set(value));
+				if (read_value != value && failures++ < 5) {
+					std::cerr << "stage " << stage << " coordinate " << i << ": set " << value << " but got " << read_value << "\n";
+				}
+			}
+			if (failures > 0) {
+				std::cerr << "stage " << stage << " coordinate " << i << ": " << failures << " of " << coordinates[i].count
+					<< " values don't round-trip\n";
+				passed = false;
+			}
+		}
+
+		return passed;
+	}
+}
+
+int main() {
+	bool passed = true;
+	for (int stage = 0; stage < 4; stage++) {
+		passed = test_coordinates_round_trip(stage) && passed;
+	}
+	std::cout << (passed ? "All tests passed\n" : "Tests failed\n");
+
+	return passed ? 0 : 1;
+}